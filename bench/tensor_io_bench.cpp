@@ -0,0 +1,113 @@
+// Throughput of the tensor file codec (tensure/tensor_io.hpp) against the
+// getline/istringstream parsing it replaced.
+//
+//   tensor_io_bench [nnz] [rank] [threads]
+//
+// Writes a random tensor with nnz nonzeros to a temporary directory in each format,
+// reads it back and prints MB/s (file bytes per second) for every step.
+
+#include "tensure/tensor_io.hpp"
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <filesystem>
+#include <unistd.h>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static double seconds_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void report(const string& step, const fs::path& file, double secs)
+{
+    double mb = fs::file_size(file) / 1e6;
+    cout << left << setw(36) << step << right << fixed << setprecision(1)
+         << setw(10) << mb << " MB" << setw(10) << mb / secs << " MB/s\n";
+}
+
+// The per-line parser the codec replaced
+static size_t baseline_read(const string& path, vector<vector<int>>& coords, vector<double>& values)
+{
+    ifstream file(path);
+    string line;
+    while (getline(file, line)) {
+        if (line.empty() || line[0] == '%') continue;
+        istringstream iss(line);
+        vector<string> toks;
+        string tok;
+        while (iss >> tok) toks.push_back(tok);
+        vector<int> coord;
+        for (size_t i = 0; i + 1 < toks.size(); i++) coord.push_back(stoi(toks[i]));
+        coords.push_back(move(coord));
+        values.push_back(stod(toks.back()));
+    }
+    return values.size();
+}
+
+int main(int argc, char* argv[])
+{
+    size_t nnz = argc > 1 ? stoull(argv[1]) : 5'000'000;
+    int rank = argc > 2 ? stoi(argv[2]) : 3;
+    unsigned threads = argc > 3 ? stoul(argv[3]) : 0;
+
+    vector<int> shape(rank, 100'000);
+    CooBuffer data;
+    data.rank = rank;
+    mt19937 gen(42);
+    uniform_int_distribution<int> coord_dist(0, shape[0] - 1);
+    uniform_real_distribution<double> value_dist(0.0, 0.5);
+    for (size_t k = 0; k < nnz; k++) {
+        for (int m = 0; m < rank; m++) data.coords.push_back(coord_dist(gen));
+        data.values.push_back(value_dist(gen));
+    }
+
+    fs::path dir = fs::temp_directory_path() / ("tensor_io_bench_" + to_string(getpid()));
+    fs::create_directories(dir);
+    cout << nnz << " nonzeros, rank " << rank << "\n";
+
+    CooBuffer back;
+    for (string ext : {".tns", ".ttx", ".bin"}) {
+        fs::path file = dir / ("T" + ext);
+
+        auto start = chrono::steady_clock::now();
+        if (!write_tensor_file(file.string(), shape, data)) {
+            cerr << "Cannot write " << file << "\n";
+            return 1;
+        }
+        report("write " + ext, file, seconds_since(start));
+
+        start = chrono::steady_clock::now();
+        read_tensor_file(file.string(), back, 1);
+        report("read " + ext + " (1 thread)", file, seconds_since(start));
+
+        if (ext != ".bin") {
+            start = chrono::steady_clock::now();
+            read_tensor_file(file.string(), back, threads);
+            report("read " + ext + " (" + (threads ? to_string(threads) : string("all")) + " threads)", file, seconds_since(start));
+        }
+        if (back.nnz() != nnz || back.coords != data.coords || back.values != data.values) {
+            cerr << "Round trip through " << ext << " changed the data\n";
+            return 1;
+        }
+
+        if (ext == ".tns") {
+            vector<vector<int>> coords;
+            vector<double> values;
+            start = chrono::steady_clock::now();
+            baseline_read(file.string(), coords, values);
+            report("read .tns (getline + istringstream)", file, seconds_since(start));
+        }
+    }
+
+    fs::remove_all(dir);
+    return 0;
+}
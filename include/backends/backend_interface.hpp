@@ -1,6 +1,11 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <exception>
 #include "tensure/formats.hpp"
 #include <dlfcn.h>
 #include <iostream>
@@ -8,6 +13,40 @@
 using namespace std;
 namespace fs = std::filesystem;
 
+// Comparison of kernel outputs against one reference output, which the session loads once
+// (see FuzzBackend::open_comparison()). compare() may be called from several threads at once.
+struct ComparisonSession {
+    virtual ~ComparisonSession() = default;
+
+    // Same result as compare_results(reference, testDir)
+    virtual bool compare(const string& testDir) = 0;
+
+    // compare() every output, using up to `threads` threads; one result per output.
+    // The first exception thrown by compare() is rethrown once all threads are done.
+    vector<bool> compare_all(const vector<string>& testDirs, unsigned threads = 1) {
+        vector<char> equal(testDirs.size());
+        vector<exception_ptr> errors(testDirs.size());
+        atomic<size_t> next{0};
+        auto work = [&] {
+            for (size_t i; (i = next++) < testDirs.size();) {
+                try {
+                    equal[i] = compare(testDirs[i]);
+                } catch (...) {
+                    errors[i] = current_exception();
+                }
+            }
+        };
+        vector<thread> workers;
+        for (unsigned t = 1; t < threads && t < testDirs.size(); t++) workers.emplace_back(work);
+        work();
+        for (auto& w : workers) w.join();
+        for (auto& e : errors) {
+            if (e) rethrow_exception(e);
+        }
+        return vector<bool>(equal.begin(), equal.end());
+    }
+};
+
 struct FuzzBackend {
     virtual ~FuzzBackend() = default;
 
@@ -15,9 +54,91 @@ struct FuzzBackend {
 
     virtual int execute_kernel(const fs::path& kernelPath, const fs::path& outputDir) = 0;
 
+    // Optional ahead-of-time build step, run before execute_kernel() (e.g. by the pipeline's
+    // compile stage). Returns 0 on success; backends without a separate build step do nothing.
+    virtual int compile_kernel(const fs::path& /*kernelPath*/, uint64_t /*timeout_ms*/) { return 0; }
+
     virtual bool compare_results(const string& refDir, const string& testDir) = 0;
+
+    // Start comparing outputs against the reference output refDir. Backends that can parse
+    // the reference once override this; the default adapter calls compare_results() for
+    // every output. timeout_ms (0: none) bounds any kernel run the session needs to make,
+    // e.g. to have a mutant write its full results again.
+    virtual unique_ptr<ComparisonSession> open_comparison(const string& refDir, uint64_t timeout_ms);
+
+    // Backend-specific counters appended to the fuzzer's progress output (empty: none)
+    virtual string stats() { return ""; }
+
+    // Whether execute_kernels() runs the kernels in fewer processes than one per kernel
+    virtual bool supports_batch() const { return false; }
+
+    // Execute several kernels, returning one execute_kernel()-style status per kernel.
+    // The default adapter simply executes them one at a time.
+    virtual vector<int> execute_kernels(const vector<fs::path>& kernelPaths, const fs::path& outputDir) {
+        vector<int> results;
+        for (auto& kernelPath : kernelPaths) {
+            results.push_back(execute_kernel(kernelPath, outputDir));
+        }
+        return results;
+    }
+
+    // Whether the timed execute_kernel()/execute_kernels() below enforce the deadline themselves,
+    // killing the kernel and returning -2. Otherwise the core can only abandon the call.
+    virtual bool supports_timeout() const { return false; }
+
+    // execute_kernel() with a deadline in milliseconds (0: none); -2 if the kernel was killed,
+    // -3 if it ran out of the memory budget (TENSURE_MEMORY_LIMIT_MB, see tensure/process.hpp)
+    virtual int execute_kernel(const fs::path& kernelPath, const fs::path& outputDir, uint64_t /*timeout_ms*/) {
+        return execute_kernel(kernelPath, outputDir);
+    }
+
+    // execute_kernels() with a deadline of timeout_ms per kernel
+    virtual vector<int> execute_kernels(const vector<fs::path>& kernelPaths, const fs::path& outputDir, uint64_t timeout_ms) {
+        vector<int> results;
+        for (auto& kernelPath : kernelPaths) {
+            results.push_back(execute_kernel(kernelPath, outputDir, timeout_ms));
+        }
+        return results;
+    }
+
+    // Whether rebind_kernel() can point a generated kernel at other shapes and data files,
+    // so it runs on new inputs without being generated or built again
+    virtual bool supports_rebinding() const { return false; }
+
+    // Point the kernel at kernelPath to the shapes and data files of `kernel`, a copy of the
+    // specification it was generated from with the same expression and formats.
+    // Returns false if the backend cannot.
+    virtual bool rebind_kernel(const fs::path& /*kernelPath*/, const tsKernel& /*kernel*/) { return false; }
+
+    // Whether execute_and_compare() compares the output while the kernel is still writing it
+    virtual bool supports_streaming() const { return false; }
+
+    // Timed execute_kernel(), then session.compare(testDir) into `equal` if the kernel succeeded.
+    // Streaming backends compare the output as it is produced and stop the kernel at the
+    // first mismatch; a kernel stopped that way returns 0 with `equal` false.
+    virtual int execute_and_compare(const fs::path& kernelPath, const fs::path& outputDir, uint64_t timeout_ms,
+                                    ComparisonSession& session, const string& testDir, bool& equal) {
+        int ret = execute_kernel(kernelPath, outputDir, timeout_ms);
+        if (ret == 0) equal = session.compare(testDir);
+        return ret;
+    }
 };
 
+// Default session: every compare() is a compare_results() call
+struct ForwardingComparisonSession : ComparisonSession {
+    ForwardingComparisonSession(FuzzBackend& backend, const string& refDir) : backend(backend), refDir(refDir) {}
+
+    bool compare(const string& testDir) override { return backend.compare_results(refDir, testDir); }
+
+private:
+    FuzzBackend& backend;
+    string refDir;
+};
+
+inline unique_ptr<ComparisonSession> FuzzBackend::open_comparison(const string& refDir, uint64_t /*timeout_ms*/) {
+    return make_unique<ForwardingComparisonSession>(*this, refDir);
+}
+
 // Utility to dynamically load/unload backend plugins
 FuzzBackend* load_backend(const std::string& so_path);
 void unload_backend(FuzzBackend* backend);
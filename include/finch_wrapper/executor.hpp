@@ -1,11 +1,31 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <string>
+#include <vector>
 
 namespace finch_wrapper {
 
 namespace fs = std::filesystem;
 
-int execute_finch_kernel(const fs::path &kernel_dir);
+// Locates the Julia project (Project.toml in the working directory or up to three
+// levels above it) and src/finch_wrapper/eval_finch.jl inside it.
+bool locate_eval_script(fs::path &project_root, fs::path &eval_script);
+
+// `julia --project=<project_root>`, plus --sysimage when a Finch system image is
+// found: FINCH_SYSIMAGE if set (empty disables it), else the one the
+// `finch_sysimage` target builds.
+std::vector<std::string> julia_command(const fs::path &project_root);
+
+// Runs eval_finch.jl on kernel_dir/kernel.json under the process supervisor.
+// Returns the ProcessResult::status() convention (-2 if killed at timeout_ms).
+int execute_finch_kernel(const fs::path &kernel_dir, uint64_t timeout_ms = 0);
+
+// Runs `eval_finch.jl --batch` on kernel_dir/kernel.json of every directory in one
+// Julia process, which appends "<index> <status>" lines to status_file. Returns the
+// process's status; kernels without a line in status_file were not run.
+int execute_finch_batch(const std::vector<fs::path> &kernel_dirs,
+                        const fs::path &status_file, uint64_t timeout_ms = 0);
 
 } // namespace finch_wrapper
@@ -1,21 +1,60 @@
 #pragma once
 #include "backends/backend_interface.hpp"
+#include "finch_wrapper/julia_worker.hpp"
 
 #include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace std;
 namespace fs = std::filesystem;
 
 struct FinchBackend : public FuzzBackend {
+  FinchBackend();
+
   bool generate_kernel(const vector<string> &mutated_kernel_file_names,
                        const fs::path &output_dir) override;
 
   int execute_kernel(const fs::path &kernelPath,
                      const fs::path &outputDir) override;
 
+  // Julia runs under the process supervisor, killed at the deadline
+  bool supports_timeout() const override { return true; }
+
+  int execute_kernel(const fs::path &kernelPath, const fs::path &outputDir,
+                     uint64_t timeout_ms) override;
+
+  // Without workers, an iteration's kernels share one `eval_finch.jl --batch`
+  // process; workers already amortize Julia startup and memoize kernels
+  bool supports_batch() const override { return true; }
+
+  vector<int> execute_kernels(const vector<fs::path> &kernelPaths,
+                              const fs::path &outputDir) override;
+
+  vector<int> execute_kernels(const vector<fs::path> &kernelPaths,
+                              const fs::path &outputDir,
+                              uint64_t timeout_ms) override;
+
   bool compare_results(const string &refDir, const string &testDir) override;
+
+  // Parses the reference output once for all mutants
+  unique_ptr<ComparisonSession> open_comparison(const string &refDir, uint64_t timeout_ms) override;
+
+  string stats() override;
+
+private:
+  // Kernels go to a persistent Julia worker per fuzzer thread unless FINCH_WORKER=0
+  bool use_worker = true;
+  fs::path project_root;
+  fs::path eval_script;
+  mutex workers_mtx;
+  map<thread::id, unique_ptr<finch_wrapper::JuliaWorker>> workers;
+  // The calling thread's worker, created on first use; nullptr if workers are off
+  finch_wrapper::JuliaWorker *worker();
 };
 
 // Plugin entry points
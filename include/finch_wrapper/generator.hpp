@@ -1,5 +1,7 @@
 #pragma once
 
+#include "tensure/formats.hpp"
+
 #include <filesystem>
 #include <string>
 #include <vector>
@@ -8,6 +10,13 @@ namespace finch_wrapper {
 
 namespace fs = std::filesystem;
 
+// Builds the Finch einsum spec read by eval_finch.jl from a TenSure kernel, the
+// in-process equivalent of convert_kernel.py (kept as the reference).
+bool finch_spec_from_kernel(const tsKernel &kernel, const fs::path &result_file,
+                            nlohmann::ordered_json &spec);
+
+// Writes out_dir/kernel.json for the kernel in input_json_path, its result going
+// to results_file[0]. Byte-identical to convert_kernel.py's output.
 bool generate_finch_kernel(const std::string &input_json_path,
                            const fs::path &out_dir,
                            const std::vector<fs::path> &results_file);
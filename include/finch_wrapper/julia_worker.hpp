@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <sys/types.h>
+
+namespace finch_wrapper {
+
+namespace fs = std::filesystem;
+
+// A long-lived `julia eval_finch.jl --server` process, so Julia startup and loading
+// Finch/TensorMarket are paid once per worker instead of once per kernel. The line
+// protocol is described at run_server() in eval_finch.jl. Used by one thread at a time.
+class JuliaWorker {
+public:
+  JuliaWorker(const fs::path &project_root, const fs::path &eval_script);
+  ~JuliaWorker();
+
+  JuliaWorker(const JuliaWorker &) = delete;
+  JuliaWorker &operator=(const JuliaWorker &) = delete;
+
+  /**
+   * Evaluate a kernel.json in the worker, (re)starting it if needed.
+   * @param json_path kernel specification to evaluate
+   * @param timeout_ms deadline for the kernel, 0 for none; the worker is killed and
+   *        restarted by the next request when it passes
+   * @return 0 on success, 1 if the kernel threw, 128 + signal if the worker crashed,
+   *         PROCESS_TIMEOUT if it was killed, or -1 if the worker could not be started
+   *         (the caller should run the kernel in a one-shot process)
+   */
+  int run(const fs::path &json_path, uint64_t timeout_ms = 0);
+
+  // Number of times the worker process was started
+  uint64_t starts() const { return start_count; }
+
+private:
+  fs::path project_root;
+  fs::path eval_script;
+  pid_t pid = -1;
+  int fd = -1;        // socket connected to the worker's stdin and stdout
+  std::string buffer; // worker output not consumed yet
+  std::atomic<uint64_t> start_count{0}; // read by stats() from other threads
+
+  bool start();
+  // Kill the worker's process group, reap it and return its ProcessResult-style status
+  int stop();
+  // Read until a line starting with prefix arrives; false on EOF, error or deadline
+  bool read_line(const std::string &prefix, uint64_t timeout_ms,
+                 std::string &line, bool &timed_out);
+};
+
+} // namespace finch_wrapper
@@ -8,10 +8,71 @@
 #include <cmath>
 #include <stdexcept>
 #include <iostream>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "backends/backend_interface.hpp"
+#include "tensure/logger.hpp"
+#include "tensure/tensor_compare.hpp"
+#include "tensure/fingerprint.hpp"
 
 namespace taco_wrapper
 {
 using namespace std;
 
 bool compare_outputs(const std::string& ref_output, const std::string& kernel_output, double total = 1e-8);
+
+// The fuzzer names results.tns; kernels over binary inputs write results.bin instead.
+// A results file counts as present when only its fingerprint was written.
+std::string resolve_results_file(const std::string& path);
+
+// Writes the full results file of a kernel that only wrote its fingerprint
+// @return false if the kernel failed
+using FullResultsWriter = std::function<bool(const std::string& results_file)>;
+
+// compare_outputs() against one reference output, which is parsed once.
+// Outputs whose fingerprint equals the reference's are equal without reading either file;
+// otherwise the files are compared, after write_full_results() produced the kernel's
+// results file if only its fingerprint was written.
+class ReferenceComparison : public ComparisonSession {
+public:
+    /**
+     * @throw std::runtime_error if the reference output does not exist
+     */
+    explicit ReferenceComparison(const std::string& ref_output, double tol = 1e-8,
+                                 FullResultsWriter write_full_results = nullptr);
+
+    /**
+     * @throw std::runtime_error if an output cannot be read, or the kernel failed or timed
+     *        out writing its full results
+     */
+    bool compare(const std::string& kernel_output) override;
+
+    // Whether compare_streamed() can be used (the reference fits a 64-bit key space)
+    bool supports_streaming();
+
+    /**
+     * Run a kernel whose text results go to a FIFO created at fifo_path, comparing them
+     * against the reference while they arrive. At the first mismatch the FIFO is closed,
+     * which kills the kernel on its next write. The FIFO is removed afterwards.
+     * @param run_kernel executes the kernel with the given results file, returning its status
+     * @param equal set when 0 is returned
+     * @return the kernel's status, or 0 if it was stopped at a mismatch
+     * @throw std::runtime_error if the FIFO cannot be created or the output is malformed
+     */
+    int compare_streamed(const std::string& fifo_path, const std::function<int(const std::string&)>& run_kernel, bool& equal);
+
+private:
+    std::string ref_file;
+    double tol;
+    FullResultsWriter write_full_results;
+    bool has_ref_fp = false;
+    OutputFingerprint ref_fp;
+
+    // Parsed on the first fingerprint mismatch
+    std::once_flag ref_once;
+    std::unique_ptr<ReferenceTensor> ref;
+    const ReferenceTensor& reference();
+};
 }
\ No newline at end of file
@@ -1,15 +1,81 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <cstdlib>
 #include <filesystem>
 #include <iostream>
 #include <chrono>
 #include <thread>
 
+#include "tensure/process.hpp"
+
 namespace taco_wrapper
 {
 using namespace std;
 
-int run_kernel(const string& kernelPath, const string& exe_file_name, const string& tool_path);
+// How generated kernel programs are compiled: TACO itself plus the prebuilt harness
+struct KernelBuildConfig {
+    string compiler = "g++";
+    string tool_path;           // TACO checkout (include/ and build/lib/)
+    string harness_include;     // directory holding taco_wrapper/taco_harness.hpp
+    string harness_pch_dir;     // directory holding taco_wrapper/taco_harness.hpp.gch, empty to compile without it
+    string harness_lib;         // libtensure_taco_harness.a
+
+    // Compiler flags shared by every kernel
+    string flags() const;
+
+    // Identifies compiled kernels in the cache: compiler, flags, and the size and mtime of
+    // the harness library, header and PCH and of libtaco, so executables built against an
+    // older harness or TACO are not served after a rebuild
+    string fingerprint() const;
+};
+
+/**
+ * Build configuration baked in by CMake (TACO_HARNESS_* definitions).
+ * @param tool_path TACO checkout the kernels are compiled against
+ */
+KernelBuildConfig default_build_config(const string& tool_path);
+
+/**
+ * Compile a generated kernel program against TACO and the harness library.
+ * @param timeout_ms deadline for the compiler, 0 for none
+ * @return 0 on success, the compiler's exit code otherwise (PROCESS_TIMEOUT if it was killed)
+ */
+int compile_kernel(const string& kernelPath, const string& exe_file_name, const KernelBuildConfig& config, uint64_t timeout_ms = 0);
+
+/**
+ * Run a kernel executable under the process supervisor (tensure/process.hpp).
+ * @param timeout_ms deadline, 0 for none; the kernel's process group is killed when it passes
+ * @return 0 on success, its exit code on failure, 128 + signal if it crashed,
+ *         PROCESS_TIMEOUT if it was killed, or PROCESS_OUT_OF_MEMORY if it ran out of the
+ *         memory budget (MEMORY_LIMIT_ENV), which it applies to itself
+ */
+int run_executable(const string& exe_file_name, const vector<string>& args, uint64_t timeout_ms = 0);
+
+// compile_kernel() followed by run_executable(), each with its own deadline
+int run_kernel(const string& kernelPath, const string& exe_file_name, const KernelBuildConfig& config, const vector<string>& args, uint64_t timeout_ms = 0);
+
+/**
+ * Execute a kernel.json through the prebuilt taco_runner, without compiling a harness.
+ * @param runner_path path to the taco_runner executable
+ * @param kernel_json kernel specification to execute
+ * @param results_files files the result tensor is written to
+ * @param timeout_ms deadline, 0 for none
+ * @return as run_executable()
+ */
+int run_taco_runner(const string& runner_path, const string& kernel_json, const vector<string>& results_files, uint64_t timeout_ms = 0);
+
+/**
+ * Execute every kernel listed in a batch manifest in a single taco_runner process.
+ * @param runner_path path to the taco_runner executable
+ * @param manifest_file one "<kernel.json> <results.tns>..." line per kernel
+ * @param status_file file the runner appends "<line> <status>" to for each kernel
+ * @param timeout_ms deadline for the whole batch, 0 for none
+ * @param kernel_timeout_ms deadline of each kernel, 0 for none; the runner kills a kernel
+ *        past it, records PROCESS_TIMEOUT for it and goes on with the next one
+ * @return the runner's own exit status (per-kernel statuses are in status_file)
+ */
+int run_taco_runner_batch(const string& runner_path, const string& manifest_file, const string& status_file, uint64_t timeout_ms = 0,
+                          uint64_t kernel_timeout_ms = 0);
 }
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <sys/types.h>
+
+namespace taco_wrapper
+{
+using namespace std;
+
+// AFL-style fork-server protocol spoken by `taco_runner --fork-server`.
+//
+// The server inherits a control channel on FORKSRV_FD and a status channel on
+// FORKSRV_FD + 1, writes a 4-byte hello on the status channel once TACO is
+// loaded, then serves requests until the control channel is closed:
+//   request:  uint32 length, then "<kernel.json> <results.tns>..." (length bytes)
+//   reply:    int32 pid of the forked child as soon as it is running, then its
+//             int32 wait status once it has been reaped
+// Every request runs in a fresh child forked from the initialized server, so a
+// crashing kernel only takes down its own child. The child leads its own process
+// group, which the client kills when the request's deadline passes.
+constexpr int FORKSRV_FD = 198;
+
+// Client side of the protocol: one server process, used by a single thread at a time
+class ForkServer {
+public:
+    explicit ForkServer(const string& runner_path);
+    ~ForkServer();
+
+    ForkServer(const ForkServer&) = delete;
+    ForkServer& operator=(const ForkServer&) = delete;
+
+    /**
+     * Execute a kernel.json in a child forked by the server, (re)starting the server if needed.
+     * @param kernel_json kernel specification to execute
+     * @param results_files files the result tensor is written to
+     * @param timeout_ms deadline, 0 for none; the child's process group is killed when it passes
+     * @return 0 on success, the runner's exit code on failure, 128 + signal if the kernel
+     *         crashed, PROCESS_TIMEOUT if it was killed, PROCESS_OUT_OF_MEMORY if it ran out
+     *         of the memory budget, or -1 if the server is unusable
+     *         (the caller should run the kernel itself)
+     */
+    int run(const string& kernel_json, const vector<string>& results_files, uint64_t timeout_ms = 0);
+
+private:
+    string runner_path;
+    pid_t server_pid = -1;
+    int ctl_fd = -1;        // our end of the control channel
+    int st_fd = -1;         // our end of the status channel
+
+    bool start();
+    void stop();
+};
+
+}
@@ -13,7 +13,7 @@ typedef struct TacoTensor {
     vector<char> idxs;
     vector<int> shape;
     vector<TensorFormat> fmt;
-    string dataFilename;
+    int dataArgIndex = -1;  // argv index of the tensor's data file, -1 if it has none
 
     TacoTensor() {}
 
@@ -21,7 +21,10 @@ typedef struct TacoTensor {
     string initilization_string(string tab_space)
     {   
         ostringstream oss;
-        oss << tab_space << "Tensor<double> " << name << "(\"" << name << "\", {" << join(shape, ",") << "}, Format({";
+        // Extents come from the command line (read_dims()), so the program fits any shapes
+        vector<string> dims;
+        for (char idx : idxs) dims.push_back("dims.at('" + string(1, idx) + "')");
+        oss << tab_space << "Tensor<double> " << name << "(\"" << name << "\", {" << join(dims, ",") << "}, Format({";
         string dataFormat = "";
         for (int i = 0; i < fmt.size(); i++)
         {
@@ -33,11 +36,9 @@ typedef struct TacoTensor {
         }
         oss << dataFormat << "}));\n";
 
-        if (dataFilename != "-")
+        if (dataArgIndex > 0)
         {
-            fs::path datafile(dataFilename);
-            fs::path abs_datafile = std::filesystem::absolute(std::filesystem::current_path() / datafile);
-            oss << tab_space << "read_taco_file(\"" << abs_datafile.string() << "\", " << name << ");\n";
+            oss << tab_space << "read_taco_file(argv[" << dataArgIndex << "], " << name << ");\n";
             oss << tab_space << name << ".pack();\n\n";
         }
         
@@ -45,9 +46,24 @@ typedef struct TacoTensor {
     }
 } TacoTensor;
 
-// bool generate_taco_kernel(const tsKernel& kernel, const fs::path& outFile);
-bool generate_taco_kernel(const tsKernel& kernel, const fs::path& out_file, std::vector<fs::path> results_file);
-string generate_program(const tsKernel &kernel_info, std::vector<fs::path> results_file);
-// string generate_program(const tsKernel &kernel_info, const string& results_file);
+/**
+ * Index extents a generated program expects as its first argument: "i=3,j=4,..."
+ * (usage: <program> <extents> <data files...> <results files...>).
+ * @param kernel kernel the program is executed for
+ */
+string kernel_dims(const tsKernel& kernel);
+
+/**
+ * Data files a generated program expects on its command line, in argument order
+ * (usage: <program> <extents> <data files...> <results files...>).
+ * @param kernel kernel the program was generated from
+ * @return data file of every input tensor, in kernel.tensors order
+ */
+vector<string> kernel_data_files(const tsKernel& kernel);
+
+// Generated programs take their index extents, data and result files as arguments, so the
+// source only depends on the expression and formats: one build serves every shape and dataset.
+bool generate_taco_kernel(const tsKernel& kernel, const fs::path& out_file);
+string generate_program(const tsKernel &kernel_info);
 
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <filesystem>
+
+namespace taco_wrapper
+{
+using namespace std;
+namespace fs = std::filesystem;
+
+/**
+ * Content-addressed cache of compiled kernel executables, persisted on disk.
+ * Entries are keyed by a hash of the generated program, which takes its data and
+ * result paths and its index extents as arguments, so kernels with the same expression and
+ * formats share one build across iterations, shapes and runs. Recency is tracked through the entries'
+ * modification time; the least recently used entries are evicted once the size or
+ * entry limit is exceeded.
+ */
+class KernelCache {
+public:
+    KernelCache(const fs::path& dir, uintmax_t max_bytes, size_t max_entries);
+
+    /**
+     * Hash the normalized kernel source together with anything else the build depends on.
+     * @param source generated program
+     * @param build_config compiler and library configuration the program is built with
+     * @return hex key of the cache entry
+     */
+    static string key_of(const string& source, const string& build_config);
+
+    /**
+     * Place the cached executable for a kernel at exe_path (hard link, or copy).
+     * @return true on a hit, false on a miss or a hash collision
+     */
+    bool fetch(const string& key, const string& source, const fs::path& exe_path);
+
+    // Add a freshly built executable to the cache, evicting old entries if needed
+    void store(const string& key, const string& source, const fs::path& exe_path);
+
+    // Hit/miss counters and occupancy, for progress output
+    string stats();
+
+private:
+    struct Entry {
+        uintmax_t bytes;
+        fs::file_time_type last_used;
+    };
+
+    fs::path dir_;
+    uintmax_t max_bytes_;
+    size_t max_entries_;
+    map<string, Entry> index_;
+    uintmax_t total_bytes_ = 0;
+    atomic<size_t> hits_{0};
+    atomic<size_t> misses_{0};
+    mutex mtx_;
+
+    void evict_locked();
+};
+
+}
@@ -3,23 +3,95 @@
 #include "taco_wrapper/generator.hpp"
 #include "taco_wrapper/executor.hpp"
 #include "taco_wrapper/comparator.hpp"
+#include "taco_wrapper/kernel_cache.hpp"
+#include "taco_wrapper/fork_server.hpp"
 
 #include <string>
 #include <vector>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 namespace fs = std::filesystem;
 
+// How TacoBackend executes a kernel, selected with TENSURE_TACO_MODE
+enum class TacoExecMode {
+    Runner,     // run kernel.json through the prebuilt taco_runner (default)
+    Compile     // compile the generated backend_kernel.cpp with g++ and run it
+};
+
 struct TacoBackend : public FuzzBackend {
+    TacoBackend();
+
     bool generate_kernel(const vector<string>& mutated_kernel_file_names, const fs::path& output_dir) override;
 
     int execute_kernel(const fs::path& kernelPath, const fs::path& outputDir) override;
 
+    // Every kernel runs in a supervised process, killed (with its process group) at the deadline
+    bool supports_timeout() const override { return true; }
+
+    int execute_kernel(const fs::path& kernelPath, const fs::path& outputDir, uint64_t timeout_ms) override;
+
+    // Compile mode: build (or fetch from the cache) the kernel's executable ahead of execution
+    int compile_kernel(const fs::path& kernelPath, uint64_t timeout_ms) override;
+
     bool compare_results(const string& refDir,
                          const string& testDir) override;
+
+    // Parses the reference output once for all mutants
+    unique_ptr<ComparisonSession> open_comparison(const string& refDir, uint64_t timeout_ms) override;
+
+    string stats() override;
+
+    bool supports_batch() const override { return mode == TacoExecMode::Runner; }
+
+    // Runs all kernels in one taco_runner --batch process (inputs are parsed once)
+    vector<int> execute_kernels(const vector<fs::path>& kernelPaths, const fs::path& outputDir) override;
+
+    vector<int> execute_kernels(const vector<fs::path>& kernelPaths, const fs::path& outputDir, uint64_t timeout_ms) override;
+
+    // Generated programs and taco_runner both read the shapes and data files at execution time
+    bool supports_rebinding() const override { return true; }
+
+    // Rewrites the kernel.json next to the kernel; the compiled executable stays valid
+    bool rebind_kernel(const fs::path& kernelPath, const tsKernel& kernel) override;
+
+    // Text results can be streamed through a FIFO in either execution mode
+    bool supports_streaming() const override { return true; }
+
+    int execute_and_compare(const fs::path& kernelPath, const fs::path& outputDir, uint64_t timeout_ms,
+                            ComparisonSession& session, const string& testDir, bool& equal) override;
+
+private:
+    TacoExecMode mode = TacoExecMode::Runner;
+    fs::path runner_path;
+    unique_ptr<taco_wrapper::KernelCache> kernel_cache;  // compile mode only
+
+    // Runner mode: one persistent taco_runner --fork-server per worker thread
+    bool use_fork_server = true;
+    mutex fork_servers_mtx;
+    map<thread::id, unique_ptr<taco_wrapper::ForkServer>> fork_servers;
+    taco_wrapper::ForkServer& fork_server();
+
+    // Mutants write just a fingerprint of large results (TACO_FINGERPRINT=0 disables it)
+    bool fingerprint_mutants = true;
+
+    // Execute the kernel abs_srcPath (in abs_outPath, next to its kernel.json), writing results
+    int run_kernel(const fs::path& abs_srcPath, const fs::path& abs_outPath, const vector<string>& results, uint64_t timeout_ms);
+
+    // Compile abs_srcPath into exe_path, through the kernel cache when enabled
+    int build_executable(const fs::path& abs_srcPath, const fs::path& exe_path, uint64_t timeout_ms);
+
+    // "results.bin" for kernels over binary inputs, "results.tns" otherwise
+    string results_name(const fs::path& kernel_dir) const;
+
+    // Files the result of the kernel in kernel_dir is written to
+    vector<string> results_files(const fs::path& kernel_dir) const;
 };
 
 // Plugin entry points
@@ -0,0 +1,92 @@
+#ifndef TACO_WRAPPER_TACO_HARNESS_HPP
+#define TACO_WRAPPER_TACO_HARNESS_HPP
+
+// Runtime support for the programs emitted by generate_program().
+//
+// Generated kernels include this header first and link against the
+// tensure_taco_harness static library, so they only contain the tensor
+// declarations and the expression. The build precompiles this header (and
+// with it taco.h); keep it self-contained and free of build-specific macros,
+// or the precompiled copy stops matching the kernels compiled against it.
+
+#include "taco.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+
+namespace taco_harness {
+
+// Tolerance results are fingerprinted with (see tensure/fingerprint.hpp); the same as
+// taco_wrapper::compare_outputs() uses
+constexpr double RESULTS_TOLERANCE = 1e-8;
+
+// Outputs with fewer nonzeros are written in full even when only a fingerprint is asked
+// for; TACO_FINGERPRINT_FULL_NNZ overrides it
+constexpr uint64_t FINGERPRINT_FULL_RESULTS_MAX_NNZ = 1 << 16;
+
+// argv[DIMS_ARG] holds the index extents, the data files follow it
+constexpr int DIMS_ARG = 1;
+constexpr int FIRST_DATA_ARG = 2;
+
+/**
+ * Apply the fuzzer's --memory-budget (MEMORY_LIMIT_ENV in tensure/process.hpp) to this
+ * process as its address space limit, and make a failed operator new exit with
+ * OUT_OF_MEMORY_EXIT_CODE instead of aborting on std::bad_alloc. Call it after compile():
+ * TACO runs the system compiler from there, which must not run under the limit.
+ * Allocations of the generated code use malloc unchecked, so running out there still
+ * crashes. Does nothing without a budget.
+ */
+void limit_memory();
+
+/**
+ * Exit with a usage message unless the command line holds the index extents and the
+ * kernel's data files, followed by at least one results file.
+ * @param num_inputs number of data files the kernel reads
+ * @param input_names names of the tensors read, in argument order (for the usage message)
+ */
+void check_args(int argc, char* argv[], int num_inputs, const std::string& input_names);
+
+/**
+ * Parse the index extents of a kernel ("i=3,j=4,..."), so a compiled kernel runs on any
+ * shapes. Exits with an error message unless every index in idxs gets a positive extent.
+ * @param idxs the kernel's index variables
+ * @return extent of every index
+ */
+std::map<char, int> read_dims(const char* arg, const std::string& idxs);
+
+/**
+ * Insert every nonzero of a tensor file into T: "<i> <j> ... <value>" lines with 0-based
+ * coordinates (".tns", ".ttx", ".mtx") or binary COO (".bin"), see tensure/tensor_io.hpp.
+ * The caller still has to pack() the tensor.
+ * @return 0, throws std::runtime_error if the file is missing or malformed
+ */
+int read_taco_file(const std::string& file_name, taco::Tensor<double>& T);
+
+/**
+ * Write T to file in the format named by its extension, with 0-based coordinates like the
+ * input files (see tensure/tensor_io.hpp).
+ * @throw std::runtime_error if the file cannot be written
+ */
+void write_tensor(const std::string& file_name, const taco::TensorBase& T);
+
+/**
+ * Write a kernel's result. A results file F is written together with its fingerprint
+ * F.fp. A results argument "F.fp" only asks for the fingerprint; F is then written only
+ * for outputs below FINGERPRINT_FULL_RESULTS_MAX_NNZ nonzeros.
+ * @throw std::runtime_error if a file cannot be written
+ */
+void write_result(const std::string& file_name, const taco::TensorBase& T);
+
+/**
+ * write_result() T to every results file on the command line (the arguments after the data files).
+ * @param num_inputs number of data files preceding the results files
+ */
+void write_results(int argc, char* argv[], int num_inputs, const taco::Tensor<double>& T);
+
+}
+
+#endif
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+// FIFO with a fixed capacity: push() blocks while full, pop() blocks while empty.
+// After close(), push() fails and pop() drains what is left before failing.
+template <typename T>
+class BoundedQueue {
+private:
+    deque<T> items;
+    size_t cap;
+    bool closed = false;
+    mutable mutex mtx;
+    condition_variable not_full;
+    condition_variable not_empty;
+
+public:
+    explicit BoundedQueue(size_t capacity) : cap(capacity == 0 ? 1 : capacity) {}
+
+    bool push(T item) {
+        unique_lock<mutex> lock(mtx);
+        not_full.wait(lock, [this]{ return closed || items.size() < cap; });
+        if (closed) return false;
+        items.push_back(std::move(item));
+        lock.unlock();
+        not_empty.notify_one();
+        return true;
+    }
+
+    bool pop(T& item) {
+        unique_lock<mutex> lock(mtx);
+        not_empty.wait(lock, [this]{ return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        lock.unlock();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> lock(mtx);
+            closed = true;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    size_t size() const {
+        lock_guard<mutex> lock(mtx);
+        return items.size();
+    }
+
+    size_t capacity() const { return cap; }
+};
+
+// A chain of stages, each with its own workers and a bounded input queue. Items flow
+// from stage to stage in order; a stage function returns false to drop an item (it is
+// destroyed right there). Bounded queues give back-pressure: a slow stage stalls the
+// ones feeding it instead of letting work pile up, and submit() blocks the producer.
+template <typename T>
+class Pipeline {
+public:
+    using StageFn = function<bool(T&)>;
+
+private:
+    struct Stage {
+        string name;
+        size_t num_workers;
+        StageFn fn;
+        BoundedQueue<T> input;
+        vector<thread> workers;
+        atomic<size_t> busy{0};
+        atomic<size_t> processed{0};
+
+        Stage(string name, size_t num_workers, size_t capacity, StageFn fn)
+            : name(std::move(name)), num_workers(num_workers == 0 ? 1 : num_workers),
+              fn(std::move(fn)), input(capacity) {}
+    };
+
+    vector<unique_ptr<Stage>> stages;
+    bool started = false;
+    bool finished = false;
+
+    void worker_loop(size_t idx) {
+        Stage& stage = *stages[idx];
+        T item;
+        while (stage.input.pop(item)) {
+            stage.busy++;
+            bool keep = false;
+            try {
+                keep = stage.fn(item);
+            } catch (...) {
+                keep = false;
+            }
+            stage.busy--;
+            stage.processed++;
+
+            if (keep && idx + 1 < stages.size()) {
+                stages[idx + 1]->input.push(std::move(item));
+            }
+            item = T();
+        }
+    }
+
+public:
+    Pipeline() = default;
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // Append a stage; capacity bounds the queue in front of it
+    void add_stage(const string& name, size_t num_workers, size_t capacity, StageFn fn) {
+        if (started)
+            throw runtime_error("add_stage on a running Pipeline");
+        stages.push_back(make_unique<Stage>(name, num_workers, capacity, std::move(fn)));
+    }
+
+    void start() {
+        if (started) return;
+        started = true;
+        for (size_t i = 0; i < stages.size(); ++i) {
+            for (size_t w = 0; w < stages[i]->num_workers; ++w) {
+                stages[i]->workers.emplace_back(&Pipeline::worker_loop, this, i);
+            }
+        }
+    }
+
+    // Feed an item to the first stage, blocking while its queue is full
+    bool submit(T item) {
+        if (!started || stages.empty()) return false;
+        return stages[0]->input.push(std::move(item));
+    }
+
+    // Stop accepting items and wait until everything submitted has left the last stage
+    void finish() {
+        if (!started || finished) return;
+        finished = true;
+        for (auto& stage : stages) {
+            stage->input.close();
+            for (auto& worker : stage->workers) {
+                if (worker.joinable()) worker.join();
+            }
+        }
+    }
+
+    // Per-stage occupancy, e.g. "generate 1/1 q0/4 | compile 3/4 q6/8 | ..."
+    // (busy/workers, then queued/capacity of the stage's input queue)
+    string occupancy() const {
+        ostringstream oss;
+        for (size_t i = 0; i < stages.size(); ++i) {
+            const Stage& stage = *stages[i];
+            if (i) oss << " | ";
+            oss << stage.name << " " << stage.busy.load() << "/" << stage.num_workers
+                << " q" << stage.input.size() << "/" << stage.input.capacity();
+        }
+        return oss.str();
+    }
+
+    ~Pipeline() { finish(); }
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tensure/formats.hpp"
+#include "tensure/tensor_io.hpp"
+
+using namespace std;
+
+// One factor of an einsum product: a tensor's nonzeros, with one index letter per mode
+struct EinsumTerm {
+    vector<char> idxs;
+    CooBuffer data;
+};
+
+// Joins probing at least this many nonzeros are split across threads
+constexpr size_t PARALLEL_EINSUM_MIN_NNZ = size_t(1) << 15;
+
+/**
+ * Evaluate out(out_idxs) = product of the terms, summed over every index that is not an
+ * output index. The terms are contracted pairwise, cheapest estimated join first; each
+ * join hashes the smaller side on the indices the two share, and indices no later term
+ * or the output needs are summed out as soon as possible.
+ * @param dims extent of every index
+ * @param out receives the nonzeros in coordinate order (exact zeros are dropped)
+ * @param threads worker threads for large joins, 0 for one per core
+ * @throw runtime_error if an output index appears in no term, or the index space of an
+ *        intermediate result has more than 2^64 points
+ */
+void evaluate_einsum(const vector<EinsumTerm>& terms, const vector<char>& out_idxs, const map<char, int>& dims,
+                     CooBuffer& out, unsigned threads = 0);
+
+/**
+ * Native reference: compute a kernel's output ("A(...) = B(...) * C(...) * ...") from
+ * its data files and write it to results_file, with its fingerprint (see
+ * tensure/fingerprint.hpp) next to it.
+ * @throw runtime_error if the expression or a data file cannot be read, or the output
+ *        cannot be written
+ */
+void evaluate_kernel(const tsKernel& kernel, const string& results_file, unsigned threads = 0);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// Summary of a kernel output that two outputs can be compared by without reading either
+// file. Nonzero values are quantized to multiples of the comparison tolerance, so equal
+// fingerprints imply every pair of values is closer than tol (the converse does not hold:
+// values straddling a quantum boundary give different fingerprints, and the caller falls
+// back to comparing the files). Zeros are skipped, like compare_tensor_files() does.
+//
+// The hash is a sum of per-nonzero hashes, so it does not depend on the order the
+// nonzeros are visited in (formats iterate in different orders); it equals the hash of
+// the nonzeros in sorted order.
+struct OutputFingerprint {
+    double tol = 0.0;
+    uint32_t rank = 0;
+    uint64_t nnz = 0;
+    uint64_t hash = 0;
+    vector<uint64_t> mode_sums; // sum of the coordinates per mode, wrapping
+
+    OutputFingerprint() = default;
+    OutputFingerprint(double tol, uint32_t rank) : tol(tol), rank(rank), mode_sums(rank) {}
+
+    // Add one entry with rank coordinates; zero values are ignored
+    void add(const int* coord, double value);
+
+    bool operator==(const OutputFingerprint& other) const;
+    bool operator!=(const OutputFingerprint& other) const { return !(*this == other); }
+
+    // One line: "TSFP 1 <tol> <rank> <nnz> <hash> <mode sums>..."
+    string to_string() const;
+};
+
+// Tolerance the fuzzer's own outputs (native reference, derived expected outputs) are
+// fingerprinted at: TACO's comparison tolerance. Comparators with another tolerance ignore them.
+constexpr double REFERENCE_FINGERPRINT_TOLERANCE = 1e-8;
+
+/**
+ * Fingerprint file of a results file ("<results file>.fp")
+ */
+string fingerprint_file_of(const string& results_file);
+
+/**
+ * @return false if the file cannot be written
+ */
+bool write_fingerprint_file(const string& path, const OutputFingerprint& fp);
+
+/**
+ * @return false if the file is missing or not a fingerprint
+ */
+bool read_fingerprint_file(const string& path, OutputFingerprint& fp);
@@ -9,6 +9,8 @@
 #include <nlohmann/json.hpp>
 #include <fstream>
 
+#include "tensure/tensor_data.hpp"
+
 using namespace std;
 using json = nlohmann::json;
 
@@ -87,66 +89,69 @@ inline bool is_equal(const vector<TensorFormat>& fmt1, const vector<TensorFormat
 enum MutationOperator {
     SPARSITY,
     COMMUTATIVITY,
+    // Data mutations: the inputs change and the expected output is derived from the
+    // reference output (see tsOutputTransform)
+    SCALE,      // scale an input by a power of two
+    PERMUTE,    // permute the modes of an input or of the output, with the data
+    SPLIT,      // keep part of an input's slices along an output index
     COUNT
 };
 
-typedef struct tsTensor
+// Change a data mutation makes to the output; a mutant's expected output is the
+// reference output with each of its transforms applied in order
+typedef struct tsOutputTransform
 {
-    char name;
-    string str_repr;
-    vector<char> idxs;
-    vector<int> shape;
-    vector<TensorFormat> storageFormat;
-} tsTensor;
+    enum Kind { Scale, Permute, Slice } kind = Scale;
+    double factor = 1.0;    // Scale: every value is multiplied by factor
+    vector<int> perm;       // Permute: mode m of the result is mode perm[m] of the input
+    int mode = 0;           // Slice: only nonzeros whose coordinate in mode is in keep remain
+    vector<int> keep;       // sorted
 
-typedef struct tsTensorData
-{
-    char tensorName;
-    vector<vector<int>> coordinate;
-    vector<double> data;
-    string tfmt;
-
-    // Insert: update if coord exists, otherwise push new coord+value
-    void insert(const std::vector<int>& coord, double value)
+    json toJson() const
     {
-        // find existing coordinate (linear search)
-        auto it = std::find_if(coordinate.begin(), coordinate.end(),
-            [&](const vector<int>& c){
-                return c == coord;
-            });
-        
-        if (it != coordinate.end()) {
-            // update the value at the same index
-            size_t idx = std::distance(coordinate.begin(), it);
-            data[idx] = value;
-        } else {
-            // append new coordinate and value
-            coordinate.push_back(coord);
-            data.push_back(value);
+        json j;
+        j["kind"] = kind == Scale ? "scale" : (kind == Permute ? "permute" : "slice");
+        if (kind == Scale) j["factor"] = factor;
+        if (kind == Permute) j["perm"] = perm;
+        if (kind == Slice) {
+            j["mode"] = mode;
+            j["keep"] = keep;
         }
+        return j;
     }
 
-    // helper: get value at coordinate (throws if not found)
-    double get(const vector<int>& coord) const {
-        auto it = find(coordinate.begin(), coordinate.end(), coord);
-        if (it == coordinate.end()) {
-            throw out_of_range("Coordinate not found");
+    static tsOutputTransform fromJson(const json& j)
+    {
+        tsOutputTransform t;
+        string kind = j["kind"].get<string>();
+        if (kind == "scale") {
+            t.kind = Scale;
+            t.factor = j["factor"].get<double>();
+        } else if (kind == "permute") {
+            t.kind = Permute;
+            t.perm = j["perm"].get<vector<int>>();
+        } else if (kind == "slice") {
+            t.kind = Slice;
+            t.mode = j["mode"].get<int>();
+            t.keep = j["keep"].get<vector<int>>();
+        } else {
+            throw invalid_argument("Unknown output transform: " + kind);
         }
-
-        size_t idx = distance(coordinate.begin(), it);
-        return data[idx];
+        return t;
     }
+} tsOutputTransform;
 
-    size_t size() const {
-        return data.size(); 
-    }
-
-    void clear() {
-        coordinate.clear();
-        data.clear();
-    }
+typedef struct tsTensor
+{
+    char name;
+    string str_repr;
+    vector<char> idxs;
+    vector<int> shape;
+    vector<TensorFormat> storageFormat;
+} tsTensor;
 
-} tsTensorData;
+// Nonzeros of a generated tensor (flat, one index array per mode), see tensure/tensor_data.hpp
+typedef TensorData tsTensorData;
 
 typedef struct tsComputation {
     string expressions;
@@ -157,6 +162,7 @@ typedef struct tsKernel
     vector<tsTensor> tensors;
     map<string, string> dataFileNames;
     vector<tsComputation> computations;
+    vector<tsOutputTransform> outputTransforms;    // empty unless data mutations were applied
 
     void saveJson(const string& file_name)
     {
@@ -189,6 +195,11 @@ typedef struct tsKernel
             j["computations"].push_back(comp);
         }
 
+        if (!outputTransforms.empty()) {
+            j["outputTransforms"] = json::array();
+            for (auto &t : outputTransforms) j["outputTransforms"].push_back(t.toJson());
+        }
+
         // Write JSON to file in pretty format
         ofstream out(file_name);
         out << j.dump(4);
@@ -210,6 +221,7 @@ typedef struct tsKernel
         tensors.clear();
         dataFileNames.clear();
         computations.clear();
+        outputTransforms.clear();
 
         // Deserialize tensors
         for (auto &t : j["tensors"])
@@ -236,5 +248,9 @@ typedef struct tsKernel
             comp.expressions = c["expression"].get<string>();
             computations.push_back(comp);
         }
+
+        if (j.contains("outputTransforms")) {
+            for (auto &t : j["outputTransforms"]) outputTransforms.push_back(tsOutputTransform::fromJson(t));
+        }
     }
 } tsKernel;
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "tensure/formats.hpp"
+#include "tensure/tensor_io.hpp"
+
+using namespace std;
+
+/**
+ * Apply a transform to a tensor in place. Data mutations use it both on an input and,
+ * for the expected output, on the reference output.
+ * @throw invalid_argument if the transform does not fit the tensor's rank
+ */
+void transform_tensor(const tsOutputTransform& transform, CooBuffer& data);
+
+/**
+ * Write the expected output of a data mutant: the reference output with the mutant's
+ * transforms applied in order, with its fingerprint (see tensure/fingerprint.hpp) next to it.
+ * @throw runtime_error if the reference output cannot be read or the result cannot be written
+ */
+void derive_expected_output(const vector<tsOutputTransform>& transforms, const string& ref_file, const string& expected_file);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace std;
+
+// Status returned when a supervised process was killed at its deadline
+constexpr int PROCESS_TIMEOUT = -2;
+
+// Status returned when a kernel ran out of its memory budget
+constexpr int PROCESS_OUT_OF_MEMORY = -3;
+
+// Exit code of a kernel whose allocation failed under its memory budget (see
+// taco_harness::limit_memory)
+constexpr int OUT_OF_MEMORY_EXIT_CODE = 99;
+
+// Environment variable with the address space limit, in MB, of each kernel process (the
+// fuzzer's --memory-budget). Kernels inherit it and apply it to themselves.
+constexpr const char* MEMORY_LIMIT_ENV = "TENSURE_MEMORY_LIMIT_MB";
+
+// The limit from MEMORY_LIMIT_ENV in bytes, 0 if there is none
+inline uint64_t memory_limit_bytes()
+{
+    const char* env = getenv(MEMORY_LIMIT_ENV);
+    return env ? strtoull(env, nullptr, 10) << 20 : 0;
+}
+
+// A kernel's status, with OUT_OF_MEMORY_EXIT_CODE read as PROCESS_OUT_OF_MEMORY while a
+// memory budget is set (without one it is an ordinary failure)
+inline int kernel_status(int status)
+{
+    return status == OUT_OF_MEMORY_EXIT_CODE && memory_limit_bytes() > 0 ? PROCESS_OUT_OF_MEMORY : status;
+}
+
+/**
+ * Outcome of a supervised child process.
+ */
+struct ProcessResult {
+    bool spawned = false;       // false if the process could not be started
+    bool timed_out = false;     // killed (with its process group) at the deadline
+    int exit_code = -1;         // exit status if the process exited normally
+    int signal = 0;             // terminating signal, 0 if the process exited normally
+    double wall_ms = 0;         // time from spawn to reap
+    double cpu_ms = 0;          // user + system time of the process
+    long peak_rss_kb = 0;       // peak resident set size
+
+    /**
+     * Collapse the result into the status convention used by the backends.
+     * @return the exit code, 128 + signal if it crashed, PROCESS_TIMEOUT on timeout,
+     *         or -1 if it could not be spawned
+     */
+    int status() const;
+
+    // One-line description for logs, e.g. "exit 0 in 12 ms (cpu 10 ms, rss 5120 KB)"
+    string summary() const;
+};
+
+/**
+ * Run a program under supervision, without a shell.
+ * The child gets its own process group; on timeout the whole group is SIGKILLed, so
+ * helpers the program started (compilers, JIT toolchains) cannot outlive it.
+ * The deadline is waited on through a pidfd where available (polling otherwise), on
+ * the calling thread.
+ * @param argv program and its arguments (the program is searched in PATH)
+ * @param timeout_ms deadline in milliseconds, 0 for none
+ * @return structured result; the caller's thread is free again once this returns
+ */
+ProcessResult run_process(const vector<string>& argv, uint64_t timeout_ms = 0);
+
+/**
+ * run_process() for a shell command line (/bin/sh -c), as a drop-in for std::system.
+ */
+ProcessResult run_shell(const string& command, uint64_t timeout_ms = 0);
@@ -12,6 +12,7 @@
 #include "tensure/formats.hpp"
 #include "tensure/utils.hpp"
 #include "tensure/logger.hpp"
+#include "tensure/tensor_io.hpp"
 
 using namespace std;
 
@@ -31,9 +32,111 @@ map<char, int> map_id_to_val(const std::vector<char>& idxs);
 TensorFormat random_format(mt19937& gen);
 
 
+// Probability that a coordinate of a generated input is a nonzero
+constexpr double INPUT_DENSITY = 0.4;
+
+/**
+ * Sizes of the generated kernels and their inputs. The defaults are the small kernels the
+ * fuzzer has always generated; large-scale mode (--scale-config, --scale-dims, ...) fills
+ * in ladders of extents and densities.
+ */
+struct GeneratorConfig {
+    // Rungs [lo, hi] of index extents. A kernel picks one rung, then every index an extent
+    // drawn log-uniformly from it. Empty: 3 to 6 (map_id_to_val()).
+    vector<pair<int, int>> dim_ladder;
+    // Each input tensor picks one of these densities
+    vector<double> density_ladder = {INPUT_DENSITY};
+    string index_pool = "ijklmn";
+    int max_rank = 6;
+    // An input expected to have more nonzeros is sampled at a lower density (exactly max_nnz
+    // nonzeros unless streamed)
+    uint64_t max_nnz = UINT64_MAX;
+    // A mode is stored dense only while the product of the extents of the modes up to it
+    // stays at most this; sparsity mutants keep to it too
+    uint64_t max_dense_volume = UINT64_MAX;
+    // Write inputs to disk as they are sampled instead of building them in memory first
+    bool stream = false;
+
+    bool scaled() const { return !dim_ladder.empty(); }
+
+    /**
+     * Defaults of large-scale mode: tensors up to rank 3 with extents from 10 to 4M in
+     * three rungs, densities from 1e-2 to 1e-6, at most 2^24 nonzeros per input and 2^26
+     * points per dense level, and inputs streamed to disk.
+     */
+    static GeneratorConfig large_scale();
+
+    /**
+     * Read the generator keys of a large-scale config file ("dims", "densities",
+     * "indexPool", "maxRank", "maxNnz", "maxDenseVolume"); other keys are left alone.
+     * "dims" holds [lo, hi] pairs or single extents.
+     * @throw invalid_argument if a value is out of range (see validate()), or a json
+     *        exception if one has the wrong type
+     */
+    void fromJson(const json& j);
+
+    /**
+     * @throw invalid_argument if a rung is empty or not positive, a density is outside
+     *        (0, 1], or the index pool repeats an index or has fewer than max_rank
+     */
+    void validate() const;
+};
+
+/**
+ * Extent of every index of the tensors, from the dimension ladder of cfg (one rung for all
+ * of them), or from map_id_to_val() without one. Extents are then halved, largest first,
+ * until the index space of every tensor has at most 2^62 points, which keeps positions
+ * and sampling in 64 bits.
+ */
+map<char, int> draw_index_extents(const vector<tsTensor>& tensors, const GeneratorConfig& cfg, mt19937& gen);
+
+// Whether every dense mode of tensor keeps to max_dense_volume (see GeneratorConfig)
+bool dense_levels_fit(const tsTensor& tensor, uint64_t max_dense_volume);
+
+// Store sparse the modes of tensor that would exceed max_dense_volume as dense levels
+void limit_dense_levels(tsTensor& tensor, uint64_t max_dense_volume);
+
 tuple<vector<tsTensor>, std::string> generate_random_einsum(int numInputs, int maxRank);
+tuple<vector<tsTensor>, std::string> generate_random_einsum(int numInputs, const GeneratorConfig& cfg);
 tuple<vector<tsTensor>, std::string> generate_random_einsum(const std::string filename_suffix);
 
-vector<string> generate_random_tensor_data(const vector<tsTensor>& tensors, string location, string file_name_suffix, string tfmt);
+/**
+ * Sample a random sparse tensor in which every coordinate is a nonzero with probability
+ * density. The sampler jumps from one nonzero to the next with geometric skips, so the
+ * cost grows with the number of nonzeros rather than with the dense volume.
+ * Values are in [0, 0.5], rounded to two decimals.
+ * @param out reset to shape, receives the nonzeros sorted by coordinate (last mode fastest)
+ * @throw overflow_error if the index space has more than 2^64 points
+ */
+void sample_sparse_tensor(const vector<int>& shape, double density, mt19937& gen, tsTensorData& out);
 
-vector<string> mutate_equivalent_kernel(const fs::path& directory, const string& original_kernel_filename, int max_mutants = -1);
\ No newline at end of file
+/**
+ * sample_sparse_tensor() with exactly nnz nonzeros (all coordinates if the tensor has fewer),
+ * at distinct uniformly chosen coordinates.
+ */
+void sample_sparse_tensor_exact(const vector<int>& shape, uint64_t nnz, mt19937& gen, tsTensorData& out);
+
+/**
+ * sample_sparse_tensor() straight into a tensor file (see TensorFileWriter), so only the
+ * writer's buffers are held in memory whatever the number of nonzeros.
+ * @return the number of nonzeros written, or -1 if the file cannot be written
+ * @throw overflow_error if the index space has more than 2^64 points
+ */
+int64_t stream_sparse_tensor(const string& path, const vector<int>& shape, double density, mt19937& gen);
+
+/**
+ * Generate random data for every input tensor (tensors[1..]) and save it under location.
+ * @param tfmt file format: "tns" and "ttx" (text) or "bin" (binary COO, see tensure/tensor_io.hpp)
+ * @param cfg densities and nonzero bound of the inputs, and whether they are streamed
+ * @return the data file names, in tensor order; shorter than the inputs if a file could not be written
+ */
+vector<string> generate_random_tensor_data(const vector<tsTensor>& tensors, string location, string file_name_suffix, string tfmt,
+                                           const GeneratorConfig& cfg = GeneratorConfig());
+
+/**
+ * @param max_dense_volume sparsity mutants store no mode dense beyond it (see GeneratorConfig)
+ * @param data_mutations whether data mutants may be generated; each reads an input and the
+ *        reference output whole, so streamed (large-scale) inputs go without them
+ */
+vector<string> mutate_equivalent_kernel(const fs::path& directory, const string& original_kernel_filename, int max_mutants = -1,
+                                        uint64_t max_dense_volume = UINT64_MAX, bool data_mutations = true);
\ No newline at end of file
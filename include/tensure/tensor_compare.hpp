@@ -0,0 +1,106 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "tensure/tensor_io.hpp"
+
+using namespace std;
+
+// First point where two tensors differ, in coordinate order
+struct TensorMismatch {
+    vector<int> coord;
+    bool in_ref = false; // the reference has a nonzero at coord
+    bool in_out = false; // the kernel output has a nonzero at coord
+    double ref_value = 0.0;
+    double out_value = 0.0;
+
+    // e.g. "(1,0,2): reference 0.25, output 0.3"
+    string to_string() const;
+};
+
+/**
+ * Compare two tensor files (any format read_tensor_file() accepts) nonzero by nonzero.
+ * Explicit zeros are skipped, so a stored 0 equals a missing entry; if a coordinate
+ * appears more than once, its first value counts.
+ *
+ * Both files are loaded into flat buffers. Each coordinate is linearized into a
+ * 64-bit key, or lexicographically ordered when the index space is too large for that.
+ * Both sides are then radix-sorted and compared in one merge pass.
+ * @param tol largest accepted absolute difference between two values
+ * @param mismatch if not null, receives the first differing coordinate when the result is false
+ * @return true if both hold the same nonzero coordinates with values within tol
+ * @throw runtime_error if a file cannot be read
+ */
+bool compare_tensor_files(const string& ref_file, const string& out_file, double tol, TensorMismatch* mismatch = nullptr);
+
+// Row-major linearization of coordinates inside a bounding box: coordinate c has key
+// sum over m of (c[m] - lo[m]) * (product of extent[m+1..])
+struct TensorKeySpace {
+    vector<int64_t> lo;
+    vector<uint64_t> extent;
+
+    uint64_t key(const int32_t* c) const;
+    bool contains(const int32_t* c) const;
+    vector<int> decode(uint64_t key) const;
+};
+
+// A reference tensor loaded and sorted once, for comparing many outputs against it.
+// compare() is const and may be called from several threads at once.
+class ReferenceTensor {
+public:
+    /**
+     * @throw runtime_error if the file cannot be read
+     */
+    explicit ReferenceTensor(const string& ref_file);
+
+    /**
+     * Same result as compare_tensor_files(ref_file, out_file, tol, mismatch), but only
+     * out_file is read and sorted.
+     * @throw runtime_error if out_file cannot be read
+     */
+    bool compare(const string& out_file, double tol, TensorMismatch* mismatch = nullptr) const;
+
+    // Whether outputs can be compared incrementally with ReferenceStream
+    bool supports_streaming() const { return keyed; }
+
+private:
+    friend class ReferenceStream;
+
+    CooBuffer data;        // as read, for the cases the keys cannot handle
+    TensorKeySpace space;  // bounding box of the nonzeros
+    bool keyed = false;    // whether the box has at most 2^64 points
+    vector<uint64_t> keys; // sorted, without duplicates
+    vector<double> values;
+};
+
+// compare() of an output that arrives in pieces and in any order, e.g. while a kernel is
+// still writing it. Each nonzero is looked up in the reference as it arrives, so a wrong
+// output is caught at its first bad nonzero (not necessarily the first in coordinate
+// order); reference nonzeros the output lacks are only known once finish() is called.
+class ReferenceStream {
+public:
+    /**
+     * @param ref must support streaming and outlive the stream
+     */
+    ReferenceStream(const ReferenceTensor& ref, double tol);
+
+    /**
+     * Check the next nonzeros of the output; duplicates after the first are ignored.
+     * @return false at the first nonzero without a reference counterpart within tol
+     */
+    bool add(const CooBuffer& chunk, TensorMismatch* mismatch = nullptr);
+
+    /**
+     * @return false if a reference nonzero never arrived
+     */
+    bool finish(TensorMismatch* mismatch = nullptr);
+
+private:
+    const ReferenceTensor& ref;
+    double tol;
+    vector<char> seen;  // per reference nonzero
+    size_t matched = 0;
+    size_t next = 0;    // reference index after the last match, tried first
+};
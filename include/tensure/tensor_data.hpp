@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "tensure/tensor_io.hpp"
+
+using namespace std;
+
+// Nonzeros of a tensor as a structure of arrays: one index array per mode, each stored
+// with the narrowest width (1, 2 or 4 bytes) its extent allows, and one value array.
+// A rank-3 tensor with extents below 256 takes 11 bytes per nonzero instead of the 12 of
+// a CooBuffer or the ~50 of a vector<int> per nonzero, and each mode is scanned
+// contiguously.
+//
+// Nonzeros are appended in any order and without a lookup, so a coordinate appended twice
+// is held twice.
+class TensorData {
+public:
+    TensorData() = default;
+
+    /**
+     * @throw invalid_argument if a dimension is negative
+     */
+    explicit TensorData(const vector<int>& shape) { reset(shape); }
+
+    // Drop every nonzero and take a new shape (which picks the index widths)
+    void reset(const vector<int>& shape);
+
+    const vector<int>& shape() const { return shape_; }
+    uint32_t rank() const { return uint32_t(shape_.size()); }
+    size_t nnz() const { return values_.size(); }
+    // Bytes per index of a mode
+    uint8_t index_width(uint32_t mode) const { return widths_[mode]; }
+    // Bytes held per nonzero, indices and value
+    size_t bytes_per_nonzero() const;
+
+    void reserve(size_t nnz);
+
+    /**
+     * Append a nonzero without looking for an existing one at the same coordinate.
+     * @throw out_of_range if the coordinate lies outside the shape
+     */
+    void append(const int32_t* coord, double value);
+    void append(const vector<int>& coord, double value) { append(coord.data(), value); }
+
+    // Index of nonzero k in one mode
+    int32_t index(uint32_t mode, size_t k) const
+    {
+        const uint8_t* p = modes_[mode].data() + k * widths_[mode];
+        switch (widths_[mode]) {
+        case 1: return *p;
+        case 2: { uint16_t v; memcpy(&v, p, 2); return v; }
+        default: { int32_t v; memcpy(&v, p, 4); return v; }
+        }
+    }
+    // Coordinate of nonzero k into out[0, rank())
+    void coord(size_t k, int32_t* out) const
+    {
+        for (uint32_t m = 0; m < rank(); m++) out[m] = index(m, k);
+    }
+    double value(size_t k) const { return values_[k]; }
+    const vector<double>& values() const { return values_; }
+
+private:
+    vector<int> shape_;
+    vector<uint8_t> widths_;
+    vector<vector<uint8_t>> modes_;
+    vector<double> values_;
+};
+
+/**
+ * Write a tensor file in the format given by the extension of path (see
+ * write_tensor_file()), with data.shape() on the size line or in the header.
+ * @return false if the file cannot be written
+ */
+bool write_tensor_file(const string& path, const TensorData& data);
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Binary COO tensor files (".bin"), an alternative to the text formats for large tensors.
+// Everything is native-endian and each section starts 8-byte aligned, so a reader can
+// mmap the file and use the arrays in place:
+//   char     magic[8]          "TSCOO\0\0\0"
+//   uint32   version           1
+//   uint32   rank
+//   uint64   nnz
+//   uint64   shape[rank]
+//   int32    coords[rank][nnz] one contiguous array per mode, 0-based
+//   (zero padding to a multiple of 8 bytes)
+//   double   values[nnz]
+constexpr uint32_t BIN_TENSOR_VERSION = 1;
+extern const char BIN_TENSOR_MAGIC[8];
+
+/**
+ * Whether path names a binary COO tensor file (by its ".bin" extension)
+ */
+bool is_bin_tensor_file(const string& path);
+
+/**
+ * Write a binary COO tensor file from one coordinate array per mode.
+ * @param mode_coords coordinates per mode, each holding values.size() entries
+ * @return false if the file cannot be written or the sizes do not match
+ */
+bool write_bin_tensor_by_mode(const string& path, const vector<int>& shape, const vector<vector<int32_t>>& mode_coords, const vector<double>& values);
+
+// Read-only mapping of a whole file (an empty file maps to size() == 0)
+class MappedFile {
+public:
+    /**
+     * @throw runtime_error if the file cannot be opened or mapped
+     */
+    explicit MappedFile(const string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return static_cast<const char*>(base); }
+    size_t size() const { return length; }
+
+private:
+    void* base = nullptr;
+    size_t length = 0;
+};
+
+// Read-only view of a binary COO tensor file, mapped into memory
+class MappedBinTensor {
+public:
+    /**
+     * @throw runtime_error if the file cannot be mapped or is not a valid binary tensor
+     */
+    explicit MappedBinTensor(const string& path);
+
+    uint32_t rank() const { return rank_; }
+    uint64_t nnz() const { return nnz_; }
+    uint64_t dim(size_t mode) const { return shape_[mode]; }
+    // nnz() coordinates of one mode
+    const int32_t* coords(size_t mode) const { return coords_ + mode * nnz_; }
+    const double* values() const { return values_; }
+
+private:
+    MappedFile file;
+    uint32_t rank_ = 0;
+    uint64_t nnz_ = 0;
+    const uint64_t* shape_ = nullptr;
+    const int32_t* coords_ = nullptr;
+    const double* values_ = nullptr;
+};
+
+// Text COO files: one "<i> <j> ... <value>" line per nonzero with 0-based coordinates.
+// ".ttx" and ".mtx" files start with a "%%MatrixMarket" header and a size line
+// "<dim>... <nnz>"; lines starting with '%' or '#' are comments. The codec maps the
+// file and parses it in place with from_chars, and writes with to_chars through a
+// fixed buffer, so no memory is allocated per line.
+
+// Coordinates of nonzero k are coords[k * rank, (k + 1) * rank)
+struct CooBuffer {
+    uint32_t rank = 0;
+    vector<int> shape; // from the size line or binary header, empty for ".tns"
+    vector<int32_t> coords;
+    vector<double> values;
+
+    size_t nnz() const { return values.size(); }
+    const int32_t* coord(size_t k) const { return coords.data() + k * rank; }
+    void clear()
+    {
+        rank = 0;
+        shape.clear();
+        coords.clear();
+        values.clear();
+    }
+};
+
+// Text files at least this large are split into chunks parsed by separate threads
+constexpr size_t PARALLEL_PARSE_MIN_BYTES = size_t(4) << 20;
+
+/**
+ * Read a ".tns", ".ttx", ".mtx" or ".bin" tensor file into out, replacing its contents.
+ * Reusing out across calls reuses its buffers.
+ * @param threads parser threads for large text files, 0 for one per core
+ * @throw runtime_error if the file cannot be read or a line is malformed (the message
+ *        names the file and the line)
+ */
+void read_tensor_file(const string& path, CooBuffer& out, unsigned threads = 0);
+
+// Parser for a ".tns" text stream that arrives in pieces, e.g. through a pipe while a
+// kernel writes it. A line split across pieces is held back until it is complete.
+class TextTensorStream {
+public:
+    // name only appears in error messages
+    explicit TextTensorStream(const string& name) : name(name) {}
+
+    /**
+     * Append the nonzeros of the complete lines in [data, data + size) to out.
+     * @throw runtime_error if a line is malformed or changes the rank
+     */
+    void feed(const char* data, size_t size, CooBuffer& out);
+
+    /**
+     * Append the last line, if the stream did not end with a newline.
+     * @throw runtime_error if it is malformed
+     */
+    void finish(CooBuffer& out);
+
+private:
+    string name;
+    string partial; // incomplete last line of the previous piece
+    int rank = -1;
+
+    void parse(const char* p, const char* end, CooBuffer& out);
+};
+
+/**
+ * Write a tensor file in the format given by the extension of path (".tns", ".ttx",
+ * ".mtx" or ".bin"), from flat buffers. See tensure/tensor_data.hpp for the overload
+ * taking a TensorData.
+ * @param shape written to the size line or header; data.shape is ignored
+ * @return false if the file cannot be written
+ */
+bool write_tensor_file(const string& path, const vector<int>& shape, const CooBuffer& data);
+
+// Writes a tensor file one nonzero at a time through fixed-size buffers, for tensors too
+// large to hold in memory first. A ".tns" file is written in place. The size line of a
+// ".ttx" or ".mtx" file and the sections of a ".bin" file depend on the nonzero count,
+// so those are spooled to "<path>.part<n>" files and put together by close().
+class TensorFileWriter {
+public:
+    // Check is_open() before adding nonzeros; it turns false again at close()
+    TensorFileWriter(const string& path, const vector<int>& shape);
+    // Removes the spool files, and the file itself unless close() succeeded
+    ~TensorFileWriter();
+
+    TensorFileWriter(const TensorFileWriter&) = delete;
+    TensorFileWriter& operator=(const TensorFileWriter&) = delete;
+
+    bool is_open() const { return open; }
+    uint64_t nnz() const { return count; }
+
+    /**
+     * @throw out_of_range if the coordinate lies outside the shape
+     */
+    void add(const int32_t* coord, double value);
+
+    /**
+     * Finish the file.
+     * @return false if any write failed
+     */
+    bool close();
+
+private:
+    struct Spools;
+
+    string path;
+    vector<int> shape;
+    uint64_t count = 0;
+    bool open = false;
+    bool closed = false;
+    unique_ptr<Spools> spools;
+};
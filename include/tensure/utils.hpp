@@ -13,6 +13,8 @@
 
 #include "tensure/formats.hpp"
 #include "tensure/logger.hpp"
+#include "tensure/tensor_io.hpp"
+#include "tensure/tensor_compare.hpp"
 
 namespace fs = std::filesystem;
 
@@ -103,7 +105,8 @@ void ensure_directory_exists(const std::string& path);
 bool generate_ref_kernel(const vector<tsTensor>& tensors, const vector<string>& computations, const vector<string>& dataFileNames, string file_name);
 
 /**
- * Utility: Compare two tensor output files for equality within a tolerance
+ * Utility: Compare two tensor output files for equality within a tolerance (see
+ * compare_tensor_files()); the first mismatching coordinate is logged
  * @param ref_output reference output file path
  * @param kernel_output kernel output file path
  * @param tol tolerance for floating-point comparison
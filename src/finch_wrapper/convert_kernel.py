@@ -1,3 +1,7 @@
+# Reference implementation of the kernel.json -> Finch spec conversion. The Finch
+# backend does the same in-process (finch_wrapper::generate_finch_kernel); keep the
+# two in sync, their output is meant to be byte-identical.
+
 import json
 import os
 import re
@@ -89,14 +89,13 @@ function emit_einsum_block(name, spec)
     end
 end
 
-function run_eval()
-    dump = "--dump" in ARGS
-    args = filter(x -> x != "--dump", ARGS)
+"""
+    build_program(spec_path, dump)
 
-    if length(args) < 1
-        error("Usage: julia eval_finch.jl <json_spec_path> [--dump]")
-    end
-    spec_path = args[1]
+Reads a kernel spec and returns the Julia program evaluating it, written next to the
+spec as `<name>.jl` when `dump` is set.
+"""
+function build_program(spec_path, dump)
     if !isfile(spec_path)
         error("Could not find $spec_path")
     end
@@ -126,9 +125,196 @@ function run_eval()
         println("Code dumped to $output_path")
     end
 
-    eval(program)
+    return program
+end
+
+function run_eval()
+    dump = "--dump" in ARGS
+    args = filter(x -> x != "--dump", ARGS)
+
+    if length(args) < 1
+        error("Usage: julia eval_finch.jl <json_spec_path> [--dump]")
+    end
+
+    eval(build_program(args[1], dump))
+end
+
+# Kernels compiled by eval_memoized, keyed by (einsum, input formats, output format).
+# Mutants of an iteration differ only in formats and operand order, so most of them
+# reuse a kernel compiled for an earlier mutant or iteration.
+const Kernels = Module(:TenSureKernels)
+Core.eval(Kernels, :(using Finch))
+const KERNELS = Dict{Any,Any}()
+const MAX_KERNELS = 4096
+
+# Inputs of the current iteration: raw file contents and their per-format conversions
+const RAW_INPUTS = Dict{String,Any}()
+const INPUTS = Dict{Tuple{String,Vector{String}},Any}()
+const INPUT_DIR = Ref("")
+
+function load_input(file, formats)
+    dir = dirname(file)
+    if dir != INPUT_DIR[]
+        # A new iteration: drop the previous one's tensors
+        empty!(RAW_INPUTS)
+        empty!(INPUTS)
+        INPUT_DIR[] = dir
+    end
+    get!(INPUTS, (file, formats)) do
+        raw = get!(() -> fread(file), RAW_INPUTS, file)
+        Tensor(Core.eval(Kernels, compile_format(formats)), raw)
+    end
+end
+
+"""
+    compile_kernel(einsum_str, out_formats)
+
+Defines a function taking the input tensors in einsum operand order and returning
+the output tensor, with the same @einsum emit_einsum_block generates.
+"""
+function compile_kernel(einsum_str, out_formats)
+    inputs_indices_str, out_indices_str = split(einsum_str, "->")
+    parse_indices(str) = [Symbol(char) for char in str]
+
+    operands = split(inputs_indices_str, ",")
+    args = [Symbol("T", k) for k in 1:length(operands)]
+    terms = [:($(args[k])[$(parse_indices(idxs)...)]) for (k, idxs) in enumerate(operands)]
+    rhs_expr = foldl((a, b) -> :($a * $b), terms)
+    out_fmt = compile_format(out_formats)
+
+    return Core.eval(Kernels, quote
+        ($(args...),) -> begin
+            out = Tensor($out_fmt)
+            @einsum out[$(parse_indices(out_indices_str)...)] += $rhs_expr
+            out
+        end
+    end)
+end
+
+"""
+    eval_memoized(spec_path, dump)
+
+Evaluates a kernel spec like the program build_program emits, but reuses compiled
+kernels and loaded inputs across specs.
+"""
+function eval_memoized(spec_path, dump)
+    # Keeps the per-kernel .jl reproducer next to the spec
+    dump && build_program(spec_path, true)
+    spec = JSON.value(read(spec_path, String))
+
+    for key in keys(spec)
+        key_str = String(key)
+        if key_str == "\$schema"
+            continue
+        end
+
+        kernel_spec = spec[key_str]
+        einsum_str = String(kernel_spec["einsum"])
+        formats(tensor) = [String(fmt) for fmt in tensor["format"]]
+        in_formats = [formats(input) for input in kernel_spec["inputs"]]
+        out_formats = formats(kernel_spec["output"])
+
+        signature = (einsum_str, in_formats, out_formats)
+        if !haskey(KERNELS, signature)
+            length(KERNELS) >= MAX_KERNELS && empty!(KERNELS)
+            KERNELS[signature] = compile_kernel(einsum_str, out_formats)
+        end
+
+        inputs = [load_input(String(input["file"]), in_formats[k])
+                  for (k, input) in enumerate(kernel_spec["inputs"])]
+        result = Base.invokelatest(KERNELS[signature], inputs...)
+        fwrite(String(kernel_spec["output"]["file"]), result)
+    end
+end
+
+# 0 on success, 1 if the kernel threw (the exit code of a one-shot run)
+function eval_status(spec_path, dump)
+    try
+        eval_memoized(spec_path, dump)
+        return 0
+    catch err
+        showerror(stderr, err, catch_backtrace())
+        println(stderr)
+        return 1
+    finally
+        flush(stderr)
+    end
+end
+
+"""
+    run_batch()
+
+Batch mode: `--batch <status_file> <spec.json|dir>... [--dump]` evaluates every spec
+(a directory stands for the `*/kernel.json` below it, in name order) in this one
+process, appending `<index> <code>` to the status file after each. Kernels missing
+from the status file were not reached, e.g. because the process was killed.
+"""
+function run_batch()
+    dump = "--dump" in ARGS
+    args = filter(x -> x != "--dump" && x != "--batch", ARGS)
+
+    if length(args) < 2
+        error("Usage: julia eval_finch.jl --batch <status_file> <spec.json|dir>... [--dump]")
+    end
+    status_file = args[1]
+    # fread/fwrite of .tns/.ttx files come from the TensorMarket extension
+    @eval Main using TensorMarket
+
+    specs = String[]
+    for arg in args[2:end]
+        if isdir(arg)
+            for entry in sort(readdir(arg; join=true))
+                isfile(joinpath(entry, "kernel.json")) && push!(specs, joinpath(entry, "kernel.json"))
+            end
+        else
+            push!(specs, arg)
+        end
+    end
+
+    open(status_file, "a") do io
+        for (i, spec_path) in enumerate(specs)
+            status = eval_status(spec_path, dump)
+            println(io, "$(i - 1) $status")
+            flush(io)
+        end
+    end
+end
+
+"""
+    run_server()
+
+Worker mode (`--server`), kept alive by the C++ backend so Julia, Finch and
+TensorMarket are loaded once instead of per kernel. Reads one kernel spec path per
+line on stdin and answers each with `TENSURE_STATUS <code> <spec path>` on stdout,
+where code is 0 on success and 1 if the kernel threw (the exit code of a one-shot run).
+Kernels are evaluated through eval_memoized. Other output may be interleaved.
+`TENSURE_READY` is printed once the packages are loaded; the worker exits when stdin
+is closed.
+"""
+function run_server()
+    dump = "--dump" in ARGS
+    @eval Main using TensorMarket
+    println("TENSURE_READY")
+    flush(stdout)
+
+    while true
+        line = readline(stdin; keep=true)
+        isempty(line) && break  # EOF: the fuzzer is gone
+        spec_path = strip(line)
+        isempty(spec_path) && continue
+
+        status = eval_status(String(spec_path), dump)
+        println("TENSURE_STATUS $status $spec_path")
+        flush(stdout)
+    end
 end
 
 if abspath(PROGRAM_FILE) == @__FILE__
-    run_eval()
+    if "--server" in ARGS
+        run_server()
+    elseif "--batch" in ARGS
+        run_batch()
+    else
+        run_eval()
+    end
 end
@@ -1,20 +1,19 @@
 #include "finch_wrapper/executor.hpp"
+#include "tensure/process.hpp"
 #include <cstdlib>
 #include <filesystem>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace finch_wrapper {
 
 namespace fs = std::filesystem;
 
-int execute_finch_kernel(const fs::path &kernel_dir) {
-  fs::path json_path = kernel_dir / "kernel.json";
-
+bool locate_eval_script(fs::path &project_root, fs::path &eval_script) {
   // Robustly locate Project.toml to define the project root.
   // We search in the current directory and up a few levels.
   fs::path cwd = fs::current_path();
-  fs::path project_root;
   bool found_project = false;
 
   fs::path search_dir = cwd;
@@ -40,14 +39,39 @@ int execute_finch_kernel(const fs::path &kernel_dir) {
               << ". Please ensure you are running from the build directory or "
                  "project root."
               << std::endl;
-    return -1;
+    return false;
   }
 
-  fs::path eval_script = project_root / "src/finch_wrapper/eval_finch.jl";
+  eval_script = project_root / "src/finch_wrapper/eval_finch.jl";
 
   if (!fs::exists(eval_script)) {
     std::cerr << "Error: eval_finch.jl not found at " << eval_script
               << std::endl;
+    return false;
+  }
+  return true;
+}
+
+std::vector<std::string> julia_command(const fs::path &project_root) {
+  std::vector<std::string> cmd = {"julia",
+                                  "--project=" + project_root.string()};
+
+  std::string sysimage;
+#ifdef FINCH_SYSIMAGE_PATH
+  sysimage = FINCH_SYSIMAGE_PATH;
+#endif
+  if (const char *env = getenv("FINCH_SYSIMAGE"))
+    sysimage = env;
+  if (!sysimage.empty() && fs::exists(sysimage))
+    cmd.push_back("--sysimage=" + sysimage);
+  return cmd;
+}
+
+int execute_finch_kernel(const fs::path &kernel_dir, uint64_t timeout_ms) {
+  fs::path json_path = kernel_dir / "kernel.json";
+
+  fs::path project_root, eval_script;
+  if (!locate_eval_script(project_root, eval_script)) {
     return -1;
   }
 
@@ -58,17 +82,38 @@ int execute_finch_kernel(const fs::path &kernel_dir) {
 
   // Include the --project flag to use the Project.toml in the detected root
   // directory
-  std::string command = "julia --project=" + project_root.string() + " " +
-                        eval_script.string() + ' ' + json_path.string() + " --dump";
+  std::vector<std::string> cmd = julia_command(project_root);
+  cmd.insert(cmd.end(), {eval_script.string(), json_path.string(), "--dump"});
+  ProcessResult result = run_process(cmd, timeout_ms);
+
+  if (result.status() != 0) {
+    std::cerr << "Finch execution failed: " << result.summary() << std::endl;
+  }
+
+  return result.status();
+}
 
-  // std::cout << "Executing Finch kernel: " << command << std::endl;
-  int ret = std::system(command.c_str());
+int execute_finch_batch(const std::vector<fs::path> &kernel_dirs,
+                        const fs::path &status_file, uint64_t timeout_ms) {
+  fs::path project_root, eval_script;
+  if (!locate_eval_script(project_root, eval_script)) {
+    return -1;
+  }
 
-  if (ret != 0) {
-    std::cerr << "Finch execution failed with code " << ret << std::endl;
+  std::vector<std::string> cmd = julia_command(project_root);
+  cmd.insert(cmd.end(), {eval_script.string(), "--batch", status_file.string()});
+  for (auto &kernel_dir : kernel_dirs) {
+    cmd.push_back((kernel_dir / "kernel.json").string());
+  }
+  cmd.push_back("--dump");
+  ProcessResult result = run_process(cmd, timeout_ms);
+
+  if (result.status() != 0) {
+    std::cerr << "Finch batch execution failed: " << result.summary()
+              << std::endl;
   }
 
-  return ret;
+  return result.status();
 }
 
 } // namespace finch_wrapper
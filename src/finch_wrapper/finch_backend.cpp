@@ -2,12 +2,33 @@
 #include "finch_wrapper/executor.hpp"
 #include "finch_wrapper/generator.hpp"
 #include "tensure/utils.hpp"
+#include <cstdlib>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 
 using namespace finch_wrapper;
 using namespace std;
 
+FinchBackend::FinchBackend() {
+  if (const char *env = getenv("FINCH_WORKER"))
+    use_worker = string(env) != "0";
+  if (use_worker && !locate_eval_script(project_root, eval_script))
+    use_worker = false;
+}
+
+JuliaWorker *FinchBackend::worker() {
+  if (!use_worker)
+    return nullptr;
+  // One worker per fuzzer thread (started on its first kernel), so requests never interleave
+  lock_guard<mutex> lock(workers_mtx);
+  auto &worker = workers[this_thread::get_id()];
+  if (!worker)
+    worker = make_unique<JuliaWorker>(project_root, eval_script);
+  return worker.get();
+}
+
 bool FinchBackend::generate_kernel(
     const vector<string> &mutated_kernel_file_names,
     const fs::path &output_dir) {
@@ -36,72 +57,180 @@ bool FinchBackend::generate_kernel(
 
 int FinchBackend::execute_kernel(const fs::path &kernelPath,
                                  const fs::path &outputDir) {
-  // kernelPath might be passed as a file path (e.g. backend_kernel.cpp) by the
-  // core fuzzer, even if that file doesn't exist. We want the directory.
+  return execute_kernel(kernelPath, outputDir, 0);
+}
+
+// kernelPath might be passed as a file path (e.g. backend_kernel.cpp) by the
+// core fuzzer, even if that file doesn't exist. We want the directory.
+static fs::path kernel_dir_of(const fs::path &kernelPath) {
   fs::path target_dir = kernelPath;
   if (target_dir.has_extension()) {
     target_dir = target_dir.parent_path();
   }
+  return target_dir;
+}
 
-  int ret = execute_finch_kernel(target_dir);
-
-  if (ret == 0) {
-    // If this was the reference kernel execution (indicated by directory name
-    // "kernel"), we need to copy the output to the standard reference output
-    // location so that TenSure core can find it for comparison.
-    // Core expects reference output in: iter_dir/data/ref_out/
-    // target_dir is: iter_dir/backend_kernel/kernel/
-    if (target_dir.stem() == "kernel") {
-      try {
-        fs::path src_file = target_dir / "results.ttx";
-        // Go up: kernel -> backend_kernel -> iter_dir -> data -> ref_out
-        fs::path ref_out_dir =
-            target_dir.parent_path().parent_path() / "data" / "ref_out";
-        fs::path dst_file = ref_out_dir / "results.ttx";
-
-        if (fs::exists(src_file)) {
-          fs::create_directories(ref_out_dir);
-          fs::copy_file(src_file, dst_file,
-                        fs::copy_options::overwrite_existing);
-        }
-      } catch (const std::exception &e) {
-        std::cerr << "Warning: Failed to copy reference output: " << e.what()
-                  << std::endl;
-      }
+// If this was the reference kernel execution (indicated by directory name
+// "kernel"), we need to copy the output to the standard reference output
+// location so that TenSure core can find it for comparison.
+// Core expects reference output in: iter_dir/data/ref_out/
+// target_dir is: iter_dir/backend_kernel/kernel/
+static void publish_reference_output(const fs::path &target_dir) {
+  if (target_dir.stem() != "kernel")
+    return;
+  try {
+    fs::path src_file = target_dir / "results.ttx";
+    // Go up: kernel -> backend_kernel -> iter_dir -> data -> ref_out
+    fs::path ref_out_dir =
+        target_dir.parent_path().parent_path() / "data" / "ref_out";
+    fs::path dst_file = ref_out_dir / "results.ttx";
+
+    if (fs::exists(src_file)) {
+      fs::create_directories(ref_out_dir);
+      fs::copy_file(src_file, dst_file, fs::copy_options::overwrite_existing);
     }
+  } catch (const std::exception &e) {
+    std::cerr << "Warning: Failed to copy reference output: " << e.what()
+              << std::endl;
   }
+}
+
+int FinchBackend::execute_kernel(const fs::path &kernelPath,
+                                 const fs::path &outputDir,
+                                 uint64_t timeout_ms) {
+  fs::path target_dir = kernel_dir_of(kernelPath);
+
+  int ret = -1;
+  JuliaWorker *julia = worker();
+  if (julia)
+    ret = julia->run(target_dir / "kernel.json", timeout_ms);
+  // No worker, or it could not be started: one Julia process for this kernel
+  if (!julia || ret == -1)
+    ret = execute_finch_kernel(target_dir, timeout_ms);
+
+  if (ret == 0)
+    publish_reference_output(target_dir);
 
   return ret;
 }
 
-bool FinchBackend::compare_results(const string &ref, const string &test) {
-  // The core fuzzer passes full file paths (usually defaulting to .tns).
-  // Since we switched to .ttx, we need to handle the mismatch if the file
-  // passed doesn't exist but the .ttx version does.
-
-  fs::path pRef(ref);
-  fs::path pTest(test);
-
-  auto resolve_path = [](fs::path p) -> fs::path {
-    // If the path exists, use it.
-    if (fs::exists(p))
-      return p;
-
-    // If it's a .tns file that doesn't exist, try .ttx
-    if (p.extension() == ".tns") {
-      fs::path ttx_path = p;
-      ttx_path.replace_extension(".ttx");
-      if (fs::exists(ttx_path))
-        return ttx_path;
+vector<int> FinchBackend::execute_kernels(const vector<fs::path> &kernelPaths,
+                                          const fs::path &outputDir) {
+  return execute_kernels(kernelPaths, outputDir, 0);
+}
+
+vector<int> FinchBackend::execute_kernels(const vector<fs::path> &kernelPaths,
+                                          const fs::path &outputDir,
+                                          uint64_t timeout_ms) {
+  if (use_worker || kernelPaths.empty()) {
+    return FuzzBackend::execute_kernels(kernelPaths, outputDir, timeout_ms);
+  }
+
+  vector<fs::path> kernel_dirs;
+  for (auto &kernelPath : kernelPaths)
+    kernel_dirs.push_back(fs::absolute(kernel_dir_of(kernelPath)));
+
+  // Statuses live next to the kernel directories (backend_kernel/)
+  fs::path status_file = kernel_dirs[0].parent_path() / "batch_status.txt";
+  fs::remove(status_file);
+
+  // The batch shares one deadline; kernels it did not get to are executed (and
+  // timed) individually
+  int ret = execute_finch_batch(kernel_dirs, status_file,
+                                timeout_ms * kernelPaths.size());
+  if (ret != 0) {
+    cerr << "Finch batch failed with code " << ret
+         << ", executing the remaining kernels one by one\n";
+  }
+
+  map<size_t, int> statuses;
+  ifstream status_in(status_file);
+  size_t idx;
+  int status;
+  while (status_in >> idx >> status) {
+    statuses[idx] = status;
+  }
+
+  vector<int> results;
+  for (size_t i = 0; i < kernelPaths.size(); i++) {
+    auto it = statuses.find(i);
+    if (it == statuses.end()) {
+      results.push_back(execute_kernel(kernelPaths[i], outputDir, timeout_ms));
+      continue;
     }
+    if (it->second == 0)
+      publish_reference_output(kernel_dirs[i]);
+    results.push_back(it->second);
+  }
+  return results;
+}
+
+// The core fuzzer passes full file paths (usually defaulting to .tns). Since we
+// switched to .ttx, we need to handle the mismatch if the file passed doesn't
+// exist but the .ttx version does.
+static fs::path resolve_path(fs::path p) {
+  // If the path exists, use it.
+  if (fs::exists(p))
     return p;
-  };
 
-  pRef = resolve_path(pRef);
-  pTest = resolve_path(pTest);
+  // If it's a .tns file that doesn't exist, try .ttx
+  if (p.extension() == ".tns") {
+    fs::path ttx_path = p;
+    ttx_path.replace_extension(".ttx");
+    if (fs::exists(ttx_path))
+      return ttx_path;
+  }
+  return p;
+}
+
+static constexpr double COMPARE_TOLERANCE = 1e-5;
 
+bool FinchBackend::compare_results(const string &ref, const string &test) {
   // Use the global compare_outputs from tensure/utils.hpp with a tolerance
-  return ::compare_outputs(pRef.string(), pTest.string(), 1e-5);
+  return ::compare_outputs(resolve_path(ref).string(),
+                           resolve_path(test).string(), COMPARE_TOLERANCE);
+}
+
+namespace {
+
+// compare_results() against a reference output that is parsed once
+class FinchComparison : public ComparisonSession {
+public:
+  explicit FinchComparison(const string &ref)
+      : ref(resolve_path(ref).string()) {}
+
+  bool compare(const string &test) override {
+    string out_file = resolve_path(test).string();
+    TensorMismatch mismatch;
+    if (ref.compare(out_file, COMPARE_TOLERANCE, &mismatch))
+      return true;
+    LOG_INFO("Output mismatch at " + mismatch.to_string() + " (" + out_file +
+             ")");
+    return false;
+  }
+
+private:
+  ReferenceTensor ref;
+};
+
+} // namespace
+
+unique_ptr<ComparisonSession>
+FinchBackend::open_comparison(const string &refDir, uint64_t /*timeout_ms*/) {
+  return make_unique<FinchComparison>(refDir);
+}
+
+string FinchBackend::stats() {
+  if (!use_worker)
+    return "";
+  lock_guard<mutex> lock(workers_mtx);
+  uint64_t starts = 0;
+  for (auto &[id, worker] : workers)
+    starts += worker->starts();
+  // Starts beyond one per worker are restarts after a crash or timeout
+  ostringstream oss;
+  oss << "julia workers " << workers.size() << ", starts " << starts;
+  return oss.str();
 }
 
 // Plugin entry points required by TenSure's backend loader
@@ -1,7 +1,9 @@
 #include "finch_wrapper/generator.hpp"
-#include <cstdlib>
+#include "tensure/formats.hpp"
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <regex>
 #include <string>
 #include <vector>
 
@@ -9,47 +11,168 @@ namespace finch_wrapper {
 
 namespace fs = std::filesystem;
 
-bool generate_finch_kernel(const std::string &input_json_path,
-                           const fs::path &out_dir,
-                           const std::vector<fs::path> &results_file) {
-  if (results_file.empty()) {
-    std::cerr << "Error: No result file specified for Finch kernel."
-              << std::endl;
+static std::string to_finch_format(TensorFormat fmt) {
+  return fmt == TensorFormat::tsSparse ? "compressed" : "dense";
+}
+
+static std::vector<std::string>
+to_finch_format(const std::vector<TensorFormat> &fmts) {
+  std::vector<std::string> finch_fmts;
+  for (auto fmt : fmts)
+    finch_fmts.push_back(to_finch_format(fmt));
+  return finch_fmts;
+}
+
+// os.path.abspath: absolute and lexically normalized, without a trailing slash
+static std::string abspath(const std::string &path) {
+  std::string abs = fs::absolute(path).lexically_normal().string();
+  while (abs.size() > 1 && abs.back() == '/')
+    abs.pop_back();
+  return abs;
+}
+
+bool finch_spec_from_kernel(const tsKernel &kernel,
+                            const fs::path &result_file,
+                            nlohmann::ordered_json &spec) {
+  if (kernel.computations.empty()) {
+    std::cerr << "Error: No computations found in kernel spec" << std::endl;
     return false;
   }
 
-  // Locate the python script
-  // Assuming running from build directory, and script is in src/finch_wrapper
-  fs::path script_path = fs::absolute(fs::current_path() /
-                                      "../src/finch_wrapper/convert_kernel.py");
+  // Assume single computation
+  std::string expr = kernel.computations[0].expressions;
+  expr.erase(std::remove(expr.begin(), expr.end(), ' '), expr.end());
 
-  if (!fs::exists(script_path)) {
-    std::cerr << "Error: Python conversion script not found at " << script_path
-              << std::endl;
+  // Split LHS = RHS
+  if (std::count(expr.begin(), expr.end(), '=') != 1) {
+    std::cerr << "Error: Invalid expression format: " << expr << std::endl;
+    return false;
+  }
+  size_t eq = expr.find('=');
+  std::string lhs = expr.substr(0, eq);
+  std::string rhs = expr.substr(eq + 1);
+
+  // Name(indices), matched at the start of the term like re.match
+  static const std::regex access_re(R"((\w+)\(([\w,]+)\))");
+  auto parse_access = [](const std::string &term, std::string &name,
+                         std::string &indices) {
+    std::smatch match;
+    if (!std::regex_search(term, match, access_re,
+                           std::regex_constants::match_continuous))
+      return false;
+    name = match[1];
+    indices = match[2];
+    indices.erase(std::remove(indices.begin(), indices.end(), ','),
+                  indices.end());
+    return true;
+  };
+
+  // Later definitions of a name win, as in a dict built from the list
+  auto find_tensor = [&kernel](const std::string &name) -> const tsTensor * {
+    for (auto it = kernel.tensors.rbegin(); it != kernel.tensors.rend(); ++it)
+      if (name == std::string(1, it->name))
+        return &*it;
+    return nullptr;
+  };
+
+  std::string out_name, out_indices;
+  if (!parse_access(lhs, out_name, out_indices)) {
+    std::cerr << "Error: Invalid LHS format: " << lhs << std::endl;
+    return false;
+  }
+  const tsTensor *out_tensor = find_tensor(out_name);
+  if (!out_tensor) {
+    std::cerr << "Error: Output tensor " << out_name
+              << " not defined in tensors list" << std::endl;
     return false;
   }
 
-  fs::path abs_input_path = fs::absolute(input_json_path);
-  fs::path abs_out_dir = fs::absolute(out_dir);
-  fs::path abs_result_file = fs::absolute(results_file[0]);
+  nlohmann::ordered_json out_obj;
+  out_obj["name"] = out_name;
+  out_obj["file"] = abspath(result_file.string());
+  out_obj["format"] = to_finch_format(out_tensor->storageFormat);
 
-  // Construct command
-  // python3 <script> <input> <out_dir> <result_file>
-  std::string command = "python3 " + script_path.string() + " " +
-                        abs_input_path.string() + " " + abs_out_dir.string() +
-                        " " + abs_result_file.string();
+  // Parse RHS: Term * Term ...
+  nlohmann::ordered_json inputs_arr = nlohmann::ordered_json::array();
+  std::string einsum;
+  size_t start = 0;
+  while (true) {
+    size_t star = rhs.find('*', start);
+    std::string term = rhs.substr(start, star == std::string::npos
+                                             ? std::string::npos
+                                             : star - start);
+    std::string name, indices;
+    if (!parse_access(term, name, indices)) {
+      std::cerr << "Error: Invalid RHS term format: " << term << std::endl;
+      return false;
+    }
+    einsum += (einsum.empty() ? "" : ",") + indices;
 
-  // std::cout << "Generating Finch kernel with command: " << command <<
-  // std::endl;
+    const tsTensor *tensor = find_tensor(name);
+    if (!tensor) {
+      std::cerr << "Error: Input tensor " << name
+                << " not defined in tensors list" << std::endl;
+      return false;
+    }
 
-  int ret = std::system(command.c_str());
+    // Relative data files are resolved against the working directory (as the runner does)
+    auto data_it = kernel.dataFileNames.find(name);
+    std::string data_file =
+        data_it != kernel.dataFileNames.end() ? data_it->second : "";
+    data_file = (!data_file.empty() && data_file != "-") ? abspath(data_file) : "";
 
-  if (ret != 0) {
-    std::cerr << "Error: Failed to generate Finch kernel (exit code " << ret
-              << ")" << std::endl;
+    nlohmann::ordered_json input;
+    input["name"] = name;
+    input["file"] = data_file;
+    input["format"] = to_finch_format(tensor->storageFormat);
+    inputs_arr.push_back(input);
+
+    if (star == std::string::npos)
+      break;
+    start = star + 1;
+  }
+  einsum += "->" + out_indices;
+
+  nlohmann::ordered_json kernel_0;
+  kernel_0["desc"] = "Generated by TenSure Finch Wrapper";
+  kernel_0["einsum"] = einsum;
+  kernel_0["inputs"] = inputs_arr;
+  kernel_0["output"] = out_obj;
+
+  spec = nlohmann::ordered_json::object();
+  spec["kernel_0"] = kernel_0;
+  return true;
+}
+
+bool generate_finch_kernel(const std::string &input_json_path,
+                           const fs::path &out_dir,
+                           const std::vector<fs::path> &results_file) {
+  if (results_file.empty()) {
+    std::cerr << "Error: No result file specified for Finch kernel."
+              << std::endl;
     return false;
   }
 
+  nlohmann::ordered_json spec;
+  try {
+    tsKernel kernel;
+    kernel.loadJson(input_json_path);
+    if (!finch_spec_from_kernel(kernel, results_file[0], spec))
+      return false;
+  } catch (const std::exception &e) {
+    std::cerr << "Error converting kernel: " << e.what() << std::endl;
+    return false;
+  }
+
+  // Same bytes as json.dump(spec, f, indent=4) in convert_kernel.py
+  fs::create_directories(out_dir);
+  std::ofstream out(out_dir / "kernel.json");
+  out << spec.dump(4, ' ', true);
+  if (!out) {
+    std::cerr << "Error: Failed to write " << (out_dir / "kernel.json")
+              << std::endl;
+    return false;
+  }
   return true;
 }
 
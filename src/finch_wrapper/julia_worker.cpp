@@ -0,0 +1,206 @@
+#include "finch_wrapper/julia_worker.hpp"
+#include "finch_wrapper/executor.hpp"
+#include "tensure/process.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char **environ;
+
+namespace finch_wrapper {
+
+// Loading Finch (and precompiling it on first use) can take minutes
+static constexpr uint64_t WORKER_STARTUP_TIMEOUT_MS = 600'000;
+
+JuliaWorker::JuliaWorker(const fs::path &project_root,
+                         const fs::path &eval_script)
+    : project_root(project_root), eval_script(eval_script) {}
+
+JuliaWorker::~JuliaWorker() { stop(); }
+
+bool JuliaWorker::start() {
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0)
+    return false;
+
+  std::vector<std::string> args = julia_command(project_root);
+  args.insert(args.end(), {eval_script.string(), "--server", "--dump"});
+  std::vector<char *> argv;
+  for (auto &arg : args)
+    argv.push_back(arg.data());
+  argv.push_back(nullptr);
+
+  // The worker's stdin and stdout are both our socket; stderr is shared with the
+  // fuzzer. Own process group and default signals, as in run_process().
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, sv[1], STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, sv[1], STDOUT_FILENO);
+
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP |
+                                      POSIX_SPAWN_SETSIGMASK |
+                                      POSIX_SPAWN_SETSIGDEF);
+  posix_spawnattr_setpgroup(&attr, 0);
+  sigset_t mask, defaults;
+  sigemptyset(&mask);
+  posix_spawnattr_setsigmask(&attr, &mask);
+  sigemptyset(&defaults);
+  sigaddset(&defaults, SIGPIPE);
+  sigaddset(&defaults, SIGINT);
+  sigaddset(&defaults, SIGTERM);
+  posix_spawnattr_setsigdefault(&attr, &defaults);
+
+  int err = posix_spawnp(&pid, argv[0], &actions, &attr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  posix_spawnattr_destroy(&attr);
+  close(sv[1]);
+  if (err != 0) {
+    close(sv[0]);
+    pid = -1;
+    return false;
+  }
+  fd = sv[0];
+  buffer.clear();
+  start_count++;
+
+  std::string line;
+  bool timed_out = false;
+  if (!read_line("TENSURE_READY", WORKER_STARTUP_TIMEOUT_MS, line, timed_out)) {
+    std::cerr << "Julia worker failed to start"
+              << (timed_out ? " (timed out)" : "") << std::endl;
+    stop();
+    return false;
+  }
+  return true;
+}
+
+int JuliaWorker::stop() {
+  if (pid <= 0)
+    return -1;
+
+  // The worker is not reaped yet, so its process group id cannot have been reused
+  close(fd);
+  fd = -1;
+  kill(-pid, SIGKILL);
+  int wstatus = 0;
+  while (waitpid(pid, &wstatus, 0) < 0 && errno == EINTR) {
+  }
+  pid = -1;
+
+  if (WIFSIGNALED(wstatus))
+    return 128 + WTERMSIG(wstatus);
+  if (WIFEXITED(wstatus) && WEXITSTATUS(wstatus) != 0)
+    return WEXITSTATUS(wstatus);
+  return -1;
+}
+
+bool JuliaWorker::read_line(const std::string &prefix, uint64_t timeout_ms,
+                            std::string &line, bool &timed_out) {
+  using namespace std::chrono;
+  auto deadline = steady_clock::now() + milliseconds(timeout_ms);
+  timed_out = false;
+
+  while (true) {
+    // Lines that are not ours (kernel output) are dropped
+    size_t eol;
+    while ((eol = buffer.find('\n')) != std::string::npos) {
+      line = buffer.substr(0, eol);
+      buffer.erase(0, eol + 1);
+      if (line.compare(0, prefix.size(), prefix) == 0)
+        return true;
+    }
+
+    int wait_ms = -1;
+    if (timeout_ms > 0) {
+      auto remaining =
+          duration_cast<milliseconds>(deadline - steady_clock::now()).count();
+      if (remaining <= 0) {
+        timed_out = true;
+        return false;
+      }
+      wait_ms = static_cast<int>(std::min<long long>(remaining, INT32_MAX));
+    }
+    pollfd pfd{fd, POLLIN, 0};
+    int ret = poll(&pfd, 1, wait_ms);
+    if (ret < 0 && errno == EINTR)
+      continue;
+    if (ret < 0)
+      return false;
+    if (ret == 0)
+      continue; // deadline check above
+
+    char chunk[4096];
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false; // worker exited
+    buffer.append(chunk, n);
+  }
+}
+
+// send() so a dead worker surfaces as an error rather than SIGPIPE
+static bool send_all(int fd, const std::string &data) {
+  const char *p = data.data();
+  size_t len = data.size();
+  while (len > 0) {
+    ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+int JuliaWorker::run(const fs::path &json_path, uint64_t timeout_ms) {
+  if (pid <= 0 && !start())
+    return -1;
+
+  std::string request = json_path.string() + "\n";
+  if (!send_all(fd, request)) {
+    // Died between requests: restart once and resend
+    stop();
+    if (!start() || !send_all(fd, request)) {
+      stop();
+      return -1;
+    }
+  }
+
+  std::string expected = json_path.string();
+  std::string line;
+  bool timed_out = false;
+  while (read_line("TENSURE_STATUS ", timeout_ms, line, timed_out)) {
+    // "TENSURE_STATUS <code> <spec path>"
+    size_t space = line.find(' ', 15);
+    if (space == std::string::npos || line.substr(space + 1) != expected)
+      continue;
+    try {
+      return std::stoi(line.substr(15, space - 15));
+    } catch (const std::exception &) {
+      break;
+    }
+  }
+
+  // Hung, crashed or unintelligible: the next request gets a fresh worker
+  int status = stop();
+  if (timed_out)
+    return PROCESS_TIMEOUT;
+  std::cerr << "Julia worker died while running " << expected << std::endl;
+  return status;
+}
+
+} // namespace finch_wrapper
@@ -0,0 +1,19 @@
+# Builds a Julia system image with Finch, TensorMarket and LazyJSON, traced through
+# precompile_workload.jl. Run by the `finch_sysimage` CMake target:
+#   julia --project=<TenSure> build_sysimage.jl <output sysimage>
+# PackageCompiler is not a project dependency; it is loaded from the default
+# environment (julia -e 'using Pkg; Pkg.add("PackageCompiler")').
+if length(ARGS) < 1
+    error("Usage: julia --project=<TenSure> build_sysimage.jl <sysimage path>")
+end
+
+try
+    @eval using PackageCompiler
+catch
+    error("PackageCompiler is not installed; run: julia -e 'using Pkg; Pkg.add(\"PackageCompiler\")'")
+end
+
+create_sysimage([:Finch, :TensorMarket, :LazyJSON];
+                sysimage_path=ARGS[1],
+                project=dirname(Base.active_project()),
+                precompile_execution_file=joinpath(@__DIR__, "precompile_workload.jl"))
@@ -0,0 +1,30 @@
+# Precompile workload for the Finch sysimage (see build_sysimage.jl): evaluates sample
+# kernels the way eval_finch.jl does, alternating between the one-shot path and the
+# memoized path of workers and batches, so @einsum, the level formats and TensorMarket
+# I/O are compiled into the image. Kernel specs found under FINCH_WORKLOAD_DIR (e.g. the
+# backend_kernel/*/kernel.json of a kept corpus) are evaluated too.
+include(joinpath(@__DIR__, "..", "eval_finch.jl"))
+include(joinpath(@__DIR__, "sample_kernels.jl"))
+
+let dir = mktempdir()
+    specs = write_sample_kernels(dir)
+
+    workload_dir = get(ENV, "FINCH_WORKLOAD_DIR", "")
+    if !isempty(workload_dir)
+        for (root, _, files) in walkdir(workload_dir), file in files
+            file == "kernel.json" && push!(specs, joinpath(root, file))
+        end
+    end
+
+    for (n, spec) in enumerate(specs)
+        try
+            if isodd(n)
+                eval(build_program(spec, false))
+            else
+                eval_memoized(spec, false)
+            end
+        catch err
+            @warn "Workload kernel failed" spec exception = err
+        end
+    end
+end
@@ -0,0 +1,47 @@
+using Finch
+using TensorMarket
+using Random
+
+"""
+    write_sample_kernels(dir; seed=42)
+
+Writes Finch kernel specs (in the format produced by the backend's generator) and
+their input tensors to `dir`, and returns the spec paths. The einsums mirror what
+TenSure generates: two to three operands of rank one to three, with contractions,
+reductions and element-wise products, each under dense, compressed and mixed formats.
+"""
+function write_sample_kernels(dir; seed=42)
+    rng = MersenneTwister(seed)
+    mkpath(dir)
+    einsums = ["ij,jk->ik", "ij,j->i", "ijk,jk->i", "ik,kj,j->i",
+               "ij,ij->ij", "ijk,kl->ijl", "i,i->i", "ijk,ik->ij"]
+    dim = 6
+    specs = String[]
+
+    for (n, einsum) in enumerate(einsums)
+        lhs, out = split(einsum, "->")
+        operands = split(lhs, ",")
+        layouts = [r -> fill("dense", r),
+                   r -> fill("compressed", r),
+                   r -> [isodd(l) ? "dense" : "compressed" for l in 1:r]]
+
+        for (m, layout) in enumerate(layouts)
+            inputs = String[]
+            for (k, idxs) in enumerate(operands)
+                name = string('B' + k - 1)
+                file = joinpath(dir, "k$(n)_$(name).tns")
+                isfile(file) || fwrite(file, fsprand(rng, ntuple(_ -> dim, length(idxs))..., 0.4))
+                push!(inputs, json_tensor(name, file, layout(length(idxs))))
+            end
+            output = json_tensor("A", joinpath(dir, "k$(n)_$(m)_A.tns"), layout(length(out)))
+
+            spec = joinpath(dir, "kernel_$(n)_$(m).json")
+            write(spec, """{"kernel_0": {"einsum": "$einsum", "inputs": [$(join(inputs, ", "))], "output": $output}}""")
+            push!(specs, spec)
+        end
+    end
+    return specs
+end
+
+json_tensor(name, file, formats) =
+    """{"name": "$name", "file": "$file", "format": [$(join(("\"$f\"" for f in formats), ", "))]}"""
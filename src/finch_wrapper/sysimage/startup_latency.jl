@@ -0,0 +1,35 @@
+# Startup latency of one-shot eval_finch.jl runs with and without the sysimage, as
+# printed by the `finch_startup_report` CMake target:
+#   julia --project=<TenSure> startup_latency.jl <sysimage path> [runs]
+include(joinpath(@__DIR__, "sample_kernels.jl"))
+using Statistics
+
+if length(ARGS) < 1
+    error("Usage: julia --project=<TenSure> startup_latency.jl <sysimage path> [runs]")
+end
+sysimage = ARGS[1]
+runs = length(ARGS) > 1 ? parse(Int, ARGS[2]) : 5
+isfile(sysimage) || error("No sysimage at $sysimage")
+
+project = dirname(Base.active_project())
+eval_script = joinpath(@__DIR__, "..", "eval_finch.jl")
+julia = joinpath(Sys.BINDIR, Base.julia_exename())
+# One contraction over compressed operands, typical of a TenSure mutant
+spec = write_sample_kernels(mktempdir())[2]
+
+function time_runs(flags)
+    times = Float64[]
+    for _ in 1:runs
+        cmd = `$julia --project=$project $flags $eval_script $spec`
+        push!(times, @elapsed run(pipeline(cmd; stdout=devnull)))
+    end
+    return times
+end
+
+default = time_runs(String[])
+with_image = time_runs(["--sysimage=$sysimage"])
+
+println("eval_finch.jl startup, $runs runs each (seconds)")
+println("  default image : median $(round(median(default); digits=2)), min $(round(minimum(default); digits=2))")
+println("  sysimage      : median $(round(median(with_image); digits=2)), min $(round(minimum(with_image); digits=2))")
+println("  speedup       : $(round(median(default) / median(with_image); digits=1))x")
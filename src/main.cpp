@@ -9,13 +9,22 @@
 #include <fstream>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <dlfcn.h>
 #include <future>
+#include <optional>
+#include <map>
+#include <functional>
+#include <sstream>
 
 #include "tensure/logger.hpp"
 #include "tensure/random_gen.hpp"                // your generator helpers (tsTensor, etc.)
+#include "tensure/einsum.hpp"                    // native reference
+#include "tensure/metamorphic.hpp"               // expected outputs of data mutants
+#include "tensure/process.hpp"                   // memory budget of kernel processes
 #include "backends/backend_interface.hpp"       // FuzzBackend interface
 #include "tensure/ThreadPool.hpp"
+#include "tensure/Pipeline.hpp"
 
 namespace fs = std::filesystem;
 using namespace std::chrono_literals;
@@ -33,6 +42,7 @@ std::atomic<size_t> g_ref_crash_count = 0;
 std::atomic<size_t> g_crash_bug_count = 0;
 std::atomic<size_t> g_wrong_code_count = 0;
 std::atomic<size_t> g_valid_einsum_count = 0;
+std::atomic<size_t> g_over_budget_count = 0;
 
 // timestamp helper (kept from your original)
 std::string timestamp_str() {
@@ -45,11 +55,31 @@ std::string timestamp_str() {
 }
 
 // ---------- timeout runner ----------
+// Kernels that time out are retried with a longer deadline at most this many times
+static constexpr int MAX_TIMEOUT_RETRIES = 2;
+static constexpr uint64_t TIMEOUT_RETRY_INCREMENT_MS = 4000;
+
 int run_with_timeout(FuzzBackend* backend, const std::string& kernel_path, const std::string& out_dir, uint64_t timeout_ms)
 {
-    // Define the callable you want to run asynchronously
+    // Backends that supervise their own processes kill the kernel at the deadline, so the
+    // call returns in time and the worker is free again
+    if (backend->supports_timeout()) {
+        try {
+            int ret = backend->execute_kernel(kernel_path, out_dir, timeout_ms);
+            if (ret == -2) {
+                LOG_ERROR((std::ostringstream{} << "Execution timed out after " << timeout_ms << " ms: " << kernel_path).str());
+            }
+            return ret;
+        } catch (const std::exception& e) {
+            std::cerr << "Exception from timed task: " << e.what() << std::endl;
+            LOG_ERROR((std::ostringstream{} << "Exception from timed task: " << e.what()).str());
+            return -1;
+        }
+    }
+
+    // Other backends: wait on a helper thread. The kernel cannot be stopped, so the future's
+    // destructor still blocks until it finishes; -2 only marks the result as late.
     auto task = [backend, kernel_path, out_dir]() -> int {
-        // Example: actually run your kernel
         return backend->execute_kernel(kernel_path, out_dir);
     };
 
@@ -66,13 +96,50 @@ int run_with_timeout(FuzzBackend* backend, const std::string& kernel_path, const
             return -1;  // Error during execution
         }
     } else {
-        std::cerr << "Execution timed out after " << timeout_ms << " ms\n";
         std::cerr << "Execution timed out after " << timeout_ms << " ms\n";
         LOG_ERROR((std::ostringstream{} << "Execution timed out after " << timeout_ms).str());
         return -2;  // Timeout
     }
 }
 
+// Batched variant, timeout_ms per kernel. Returns an empty vector on failure or timeout.
+std::vector<int> run_batch_with_timeout(FuzzBackend* backend, const std::vector<fs::path>& kernel_paths, const std::string& out_dir, uint64_t timeout_ms)
+{
+    if (backend->supports_timeout()) {
+        try {
+            std::vector<int> results = backend->execute_kernels(kernel_paths, out_dir, timeout_ms);
+            if (results.size() == kernel_paths.size()) return results;
+            LOG_ERROR("Batch execution returned " + to_string(results.size()) + " statuses for " + to_string(kernel_paths.size()) + " kernels");
+        } catch (const std::exception& e) {
+            std::cerr << "Exception from batched task: " << e.what() << std::endl;
+            LOG_ERROR((std::ostringstream{} << "Exception from batched task: " << e.what()).str());
+        }
+        return {};
+    }
+
+    auto task = [backend, kernel_paths, out_dir]() -> std::vector<int> {
+        return backend->execute_kernels(kernel_paths, out_dir);
+    };
+
+    std::future<std::vector<int>> fut = std::async(std::launch::async, task);
+
+    uint64_t batch_timeout_ms = timeout_ms * kernel_paths.size();
+    if (fut.wait_for(std::chrono::milliseconds(batch_timeout_ms)) == std::future_status::ready) {
+        try {
+            std::vector<int> results = fut.get();
+            if (results.size() == kernel_paths.size()) return results;
+            LOG_ERROR("Batch execution returned " + to_string(results.size()) + " statuses for " + to_string(kernel_paths.size()) + " kernels");
+        } catch (const std::exception& e) {
+            std::cerr << "Exception from batched task: " << e.what() << std::endl;
+            LOG_ERROR((std::ostringstream{} << "Exception from batched task: " << e.what()).str());
+        }
+    } else {
+        std::cerr << "Batch execution timed out after " << batch_timeout_ms << " ms\n";
+        LOG_ERROR((std::ostringstream{} << "Batch execution timed out after " << batch_timeout_ms).str());
+    }
+    return {};
+}
+
 // ---------- backend plugin loader ----------
 struct PluginHandle {
     void* dl = nullptr;
@@ -162,163 +229,665 @@ void archive_failure_case(const fs::path &dir_name, const fs::path &kernel_dir,
     }
 }
 
+// ---------- fuzzing job ----------
+// Settings shared by every iteration
+struct FuzzConfig {
+    FuzzBackend* backend = nullptr;
+    fs::path out_root;
+    std::string tensor_file_format;
+    uint64_t executor_timeout_ms = 0;
+    bool batch_execution = false;
+    ThreadPool* mutant_pool = nullptr;  // --parallel-mutants: mutants run as sub-tasks on this pool
+    bool stream_compare = false;        // --stream-compare: mutant outputs are compared while they run
+    bool native_reference = false;      // --reference native: the core computes the reference output
+    size_t data_variants = 0;           // --data-variants: further inputs every kernel is executed on
+    GeneratorConfig generator;          // sizes of kernels and inputs (large-scale mode)
+    uint64_t time_budget_ms = 0;        // --time-budget: wall time per iteration, 0 for none
+};
+
 /**
- * @brief The core fuzzing task executed by a single worker thread.
+ * @brief State of one fuzzing iteration as it moves through the stages below.
+ * Destroying it finishes the iteration: the progress counter is bumped and the corpus
+ * directory is removed unless the iteration was archived as a failure.
  */
-void FuzzingJob(size_t iter, FuzzBackend* target_backend, std::mt19937::result_type seed_offset, fs::path& out_root, const std::string& tensor_file_format, const uint64_t executor_timeout_ms
-    ) {
-    // Create a thread-local RNG based on the global seed offset
-    std::mt19937 local_rng(seed_offset + iter);
-    
+struct FuzzIteration {
+    size_t iter;
+    std::mt19937 rng;
+    std::string iter_id;
+    fs::path iter_dir;
+    fs::path fail_dir;
+    fs::path iter_data_dir;
+    fs::path backend_kernel;
+
+    std::vector<std::string> mutated_file_names;    // kernel.json of the reference ([0]) and the mutants
+    std::vector<tsKernel> kernels;                  // their specifications, read before the backend moves them
+    std::vector<fs::path> kernel_paths;             // backend kernels, same order
+    std::vector<int> compile_status;                // compile stage result per kernel (empty: not run)
+    std::vector<std::optional<int>> results;        // execution status per kernel (nullopt: not executed)
+    std::vector<std::optional<bool>> equal;         // mutant output matches the reference (nullopt: left to stage_compare)
+
+    // Reference output loaded once for comparing every mutant, opened by ref_comparison()
+    std::unique_ptr<ComparisonSession> ref_comparison_session;
+    std::once_flag ref_comparison_once;
+
+    // Per data mutant: how its expected output follows from the reference output, and the
+    // session comparing against it (opened by comparison())
+    std::vector<std::vector<tsOutputTransform>> output_transforms;
+    std::vector<std::unique_ptr<ComparisonSession>> expected_sessions;
+
+    // --time-budget: the iteration stops starting work at the deadline
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    // When its last stage finished; the wait for the next one moves the deadline (run_stage())
+    std::optional<std::chrono::steady_clock::time_point> stage_done;
+    std::atomic<bool> over_budget = false;
+
+    FuzzIteration(size_t iter, std::mt19937::result_type seed_offset, const fs::path& out_root)
+        : iter(iter),
+          // Thread-independent RNG based on the global seed offset
+          rng(seed_offset + iter),
+          iter_id("iter_" + std::to_string(iter) + "_" + timestamp_str()),
+          iter_dir(out_root / "corpus" / iter_id),
+          fail_dir(out_root / "failures"),
+          iter_data_dir(iter_dir / "data"),
+          backend_kernel(iter_dir / "backend_kernel") {}
+
+    fs::path ref_out_file() const { return iter_data_dir / "ref_out" / "results.tns"; }
+
+    bool out_of_time() const { return deadline && std::chrono::steady_clock::now() >= *deadline; }
+
+    // A kernel timeout cut to the time left before the deadline (at least 1 ms, as 0 means none);
+    // without a timeout of its own the kernel gets the time left
+    uint64_t clip_timeout(uint64_t timeout_ms) const {
+        if (!deadline) return timeout_ms;
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now()).count();
+        uint64_t clipped = std::max<uint64_t>(left > 0 ? left : 0, 1);
+        return timeout_ms == 0 ? clipped : std::min(clipped, timeout_ms);
+    }
+
+    // Session comparing mutant outputs against the reference, opened on first use (thread-safe).
+    // timeout_ms bounds the kernel runs the session makes (see FuzzBackend::open_comparison()).
+    ComparisonSession& ref_comparison(FuzzBackend* backend, uint64_t timeout_ms) {
+        std::call_once(ref_comparison_once, [&] { ref_comparison_session = backend->open_comparison(ref_out_file().string(), timeout_ms); });
+        return *ref_comparison_session;
+    }
+
+    // The reference output as the backend wrote it (the extension may differ from .tns)
+    fs::path ref_out_written() const {
+        for (const char* ext : {".tns", ".bin", ".ttx"}) {
+            fs::path p = fs::path(ref_out_file()).replace_extension(ext);
+            if (fs::exists(p)) return p;
+        }
+        return ref_out_file();
+    }
+
+    // Session mutant mi is compared with. A data mutant gets its own, against the expected
+    // output derived from the reference output on first use; only one thread uses a mutant's.
+    ComparisonSession& comparison(FuzzBackend* backend, size_t mi, uint64_t timeout_ms) {
+        if (mi >= output_transforms.size() || output_transforms[mi].empty()) return ref_comparison(backend, timeout_ms);
+        auto& session = expected_sessions[mi];
+        if (!session) {
+            fs::path expected = iter_data_dir / "ref_out" / ("expected" + std::to_string(mi) + ".tns");
+            derive_expected_output(output_transforms[mi], ref_out_written().string(), expected.string());
+            session = backend->open_comparison(expected.string(), timeout_ms);
+        }
+        return *session;
+    }
+
+    FuzzIteration(const FuzzIteration&) = delete;
+    FuzzIteration& operator=(const FuzzIteration&) = delete;
+
+    ~FuzzIteration() {
+        g_completed_runs++;
+
+        bool is_iter_archived = fs::exists(fail_dir / "ref_crash" / iter_id) ||
+                                fs::exists(fail_dir / "crash" / iter_id) ||
+                                fs::exists(fail_dir / "wc" / iter_id);
+
+        if (!is_iter_archived && fs::exists(iter_dir)) {
+            try {
+                fs::remove_all(iter_dir);
+            } catch (...) {}
+        }
+    }
+};
+
+using FuzzStage = bool (*)(FuzzIteration&, const FuzzConfig&);
+
+// --time-budget: false once the iteration's deadline has passed. The first caller counts
+// and logs it; the iteration then ends without archiving anything it did not finish.
+static bool within_time_budget(FuzzIteration& it, const FuzzConfig& cfg) {
+    if (!it.out_of_time()) return true;
+    if (!it.over_budget.exchange(true)) {
+        g_over_budget_count++;
+        LOG_WARN("Iteration " + it.iter_id + " ran out of its time budget of " + to_string(cfg.time_budget_ms) + " ms");
+    }
+    return false;
+}
+
+// Stage 1: random einsum, input data, reference kernel.json and its equivalent mutants
+static bool stage_generate(FuzzIteration& it, const FuzzConfig& cfg) {
+    LOG_INFO("Starting Fuzzing Job: " + it.iter_id);
+    if (cfg.time_budget_ms > 0) it.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(cfg.time_budget_ms);
+    fs::create_directories(it.iter_dir);
+    fs::create_directories(it.iter_data_dir);
+
     // The distributed is kept local to ensure each thread uses fresh randomness
     std::uniform_int_distribution<int> dist_tensor_count(2, 5);
 
+    // Generate random kernel specification
+    auto [tensors, einsum] = generate_random_einsum(dist_tensor_count(it.rng), cfg.generator);
+    // auto [tensors, einsum] = generate_random_einsum(to_string(iter));
+    // if (!is_valid_einsum_equation(einsum)) {
+    //     return;
+    // }
+    // g_valid_einsum_count++;
+
+    LOG_INFO("Generated Random Einsum: " + einsum);
+
+    // Generate and store data for tensors
+    std::vector<std::string> datafile_names = generate_random_tensor_data(tensors, it.iter_data_dir, "", cfg.tensor_file_format, cfg.generator);
+
+    if (datafile_names.size() != tensors.size() - 1) {
+        LOG_ERROR("Tensor data generation failed for job: " + it.iter_id);
+        return false;
+    }
+
+    // Generate Reference Kernel (using the ref_backend)
+    if (!generate_ref_kernel(tensors, {einsum}, datafile_names, (it.iter_dir / "kernel.json").string())) {
+        LOG_WARN("Reference Backend Kernel Generation Failed.");
+        return false;
+    }
+    // Generate Mutants
+    // We reuse the existing logic which mutates the kernel.json file directly
+    it.mutated_file_names = mutate_equivalent_kernel(it.iter_dir, "kernel.json", 10, cfg.generator.max_dense_volume, !cfg.generator.stream);
+    LOG_INFO("Generated " + to_string(it.mutated_file_names.size() - 1) + " Equivalent Mutants.");
+
+    // Read before the backend moves the files into its kernel directories
+    it.kernels.assign(it.mutated_file_names.size(), {});
+    it.output_transforms.assign(it.mutated_file_names.size(), {});
+    it.expected_sessions.resize(it.mutated_file_names.size());
+    for (size_t mi = 0; mi < it.mutated_file_names.size(); ++mi) {
+        it.kernels[mi].loadJson(it.mutated_file_names[mi]);
+        it.output_transforms[mi] = it.kernels[mi].outputTransforms;
+    }
+    return true;
+}
+
+// Stage 2: backend-specific kernels for the reference and every mutant
+static bool stage_backend_kernels(FuzzIteration& it, const FuzzConfig& cfg) {
+    fs::create_directories(it.backend_kernel);
+    bool gen_ok = cfg.backend->generate_kernel(it.mutated_file_names, it.backend_kernel);
+    if (!gen_ok) {
+        cerr << "generate_kernel failed for iter " << it.iter_id << "\n";
+        LOG_WARN("generate_kernel failed for iter " + it.iter_id + " to generate mutated backend kernels.");
+        return false;
+    }
+
+    // Use the generated reference kernel path
+    // TODO: Make it generic
+    it.kernel_paths = {it.backend_kernel / "kernel" / "backend_kernel.cpp"};
+    for (size_t mi = 1; mi < it.mutated_file_names.size(); ++mi) {
+        it.kernel_paths.push_back(it.backend_kernel / ("kernel" + to_string(mi)) / "backend_kernel.cpp");
+    }
+    return true;
+}
+
+// Stage 3: ahead-of-time build of every kernel (a no-op for backends without one).
+// With parallel mutants only the reference is built here; each mutant's sub-task builds its own.
+static bool stage_compile(FuzzIteration& it, const FuzzConfig& cfg) {
+    it.compile_status.clear();
+    size_t count = cfg.mutant_pool ? std::min<size_t>(1, it.kernel_paths.size()) : it.kernel_paths.size();
+    for (size_t ki = 0; ki < count; ++ki) {
+        // The native reference needs no backend kernel
+        bool skip = ki == 0 && cfg.native_reference;
+        it.compile_status.push_back(skip ? 0 : cfg.backend->compile_kernel(it.kernel_paths[ki], it.clip_timeout(cfg.executor_timeout_ms)));
+    }
+    return true;
+}
+
+// Execute a mutant. With --stream-compare its output is compared while it is written and
+// the verdict stored in it.equal, so stage_compare does not read it again.
+static int run_mutant(FuzzIteration& it, const FuzzConfig& cfg, size_t mi, uint64_t timeout_ms) {
+    const fs::path& mutant_path = it.kernel_paths[mi];
+    timeout_ms = it.clip_timeout(timeout_ms);
+    if (!cfg.stream_compare) return run_with_timeout(cfg.backend, mutant_path.string(), "", timeout_ms);
+
+    bool equal = false;
+    int ret;
     try {
-        if (g_terminate) return;
-
-        std::string iter_id = "iter_" + std::to_string(iter) + "_" + timestamp_str();
-        LOG_INFO("Starting Fuzzing Job: " + iter_id);
-        
-        // Define paths
-        fs::path iter_dir = out_root / "corpus" / iter_id;
-        fs::path fail_dir = out_root / "failures";
-        fs::path iter_data_dir = iter_dir / "data";
-        fs::create_directories(iter_dir);
-        fs::create_directories(iter_data_dir);
-
-        // --- RAII GUARD: GUARANTEES CLEANUP & INCREMENT G_COUNTER ON RETURN ---
-        struct JobFinalizer {
-            fs::path& _iter_dir;
-            fs::path& _fail_dir;
-            std::string& _iter_id;
-
-            ~JobFinalizer() {
-                g_completed_runs++;
-
-                bool is_iter_archived = fs::exists(_fail_dir / "ref_crash" / _iter_id) ||
-                                        fs::exists(_fail_dir / "crash" / _iter_id) ||
-                                        fs::exists(_fail_dir / "wc" / _iter_id);
-                
-                if (!is_iter_archived && fs::exists(_iter_dir)) {
-                    try {
-                        fs::remove_all(_iter_dir);
-                    } catch (...) {}
-                }
+        ComparisonSession& session = it.comparison(cfg.backend, mi, timeout_ms);
+        ret = cfg.backend->execute_and_compare(mutant_path, "", timeout_ms, session, (mutant_path.parent_path() / "results.tns").string(), equal);
+    } catch (const std::exception& e) {
+        LOG_ERROR((std::ostringstream{} << "Exception from streamed task: " << e.what()).str());
+        return -1;
+    }
+    if (ret == -2) {
+        LOG_ERROR((std::ostringstream{} << "Execution timed out after " << timeout_ms << " ms: " << mutant_path.string()).str());
+    }
+    if (ret == 0) it.equal[mi] = equal;
+    return ret;
+}
+
+// Sub-task of one mutant (--parallel-mutants): build, execute with the same timeout retries
+// as the sequential loop, and compare against the reference right away. A crash or a
+// mismatch sets `cancel`, so siblings that have not started yet are skipped, like the
+// sequential loop's break. Kernels already running are not stopped: the timed execute_kernel()
+// has no cancellation hook, so they finish or run into their timeout.
+static void run_mutant_task(FuzzIteration& it, const FuzzConfig& cfg, size_t mi, std::atomic<bool>& cancel) {
+    if (cancel || g_terminate || !within_time_budget(it, cfg)) return;
+    const fs::path& mutant_path = it.kernel_paths[mi];
+
+    int result = cfg.backend->compile_kernel(mutant_path, it.clip_timeout(cfg.executor_timeout_ms));
+    if (result == 0 || result == -2) {
+        uint64_t timeout = cfg.executor_timeout_ms;
+        for (int attempt = 0;; ++attempt) {
+            if (cancel || g_terminate || !within_time_budget(it, cfg)) return;
+            result = run_mutant(it, cfg, mi, timeout);
+            if (result != -2) break;
+            if (attempt == MAX_TIMEOUT_RETRIES) {
+                LOG_WARN("Mutant " + to_string(mi) + " of " + it.iter_id + " timed out after " + to_string(timeout) + " ms, skipping");
+                return;
             }
-        } finalizer{iter_dir, fail_dir, iter_id};
-
-        // Generate random kernel specification
-        auto [tensors, einsum] = generate_random_einsum(dist_tensor_count(local_rng), 6);
-        // auto [tensors, einsum] = generate_random_einsum(to_string(iter));
-        // if (!is_valid_einsum_equation(einsum)) {
-        //     return;
-        // }
-        // g_valid_einsum_count++;
-        
-        LOG_INFO("Generated Random Einsum: " + einsum);
-        
-        // Generate and store data for tensors
-        std::vector<std::string> datafile_names = generate_random_tensor_data(tensors, iter_data_dir, "", tensor_file_format);
-
-        if (datafile_names.size() != tensors.size() - 1) { 
-            LOG_ERROR("Tensor data generation failed for job: " + iter_id);
-            return;
+            timeout += TIMEOUT_RETRY_INCREMENT_MS;
         }
+    }
+    if (result == PROCESS_OUT_OF_MEMORY) {
+        LOG_WARN("Mutant " + to_string(mi) + " of " + it.iter_id + " ran out of the memory budget, skipping");
+        return;
+    }
+    it.results[mi] = result;
 
-        // Generate Reference Kernel (using the ref_backend)
-        if (!generate_ref_kernel(tensors, {einsum}, datafile_names, (iter_dir / "kernel.json").string())) {
-            LOG_WARN("Reference Backend Kernel Generation Failed.");
+    if (result != 0) {
+        cancel = true;
+        return;
+    }
+    if (!it.equal[mi]) {
+        try {
+            it.equal[mi] = it.comparison(cfg.backend, mi, it.clip_timeout(cfg.executor_timeout_ms)).compare((mutant_path.parent_path() / "results.tns").string());
+        } catch (const std::exception& e) {
+            LOG_WARN("Mutant " + to_string(mi) + " of " + it.iter_id + " could not be compared (" + e.what() + "), skipping");
+            it.results[mi].reset();
             return;
         }
+    }
+    if (!*it.equal[mi]) cancel = true;
+}
 
-        // Generate Mutants
-        // We reuse the existing logic which mutates the kernel.json file directly
-        vector<string> mutated_file_names = mutate_equivalent_kernel(iter_dir, "kernel.json", 10);
-        LOG_INFO("Generated " + to_string(mutated_file_names.size() - 1) + " Equivalent Mutants.");
+// Count and archive a failed reference execution; context is appended to the message
+static void archive_ref_crash(FuzzIteration& it, int ref_result, const std::string& context) {
+    g_ref_crash_count++;
+    std::string message;
+    if (ref_result == -2) message = "Reference Kernel execution timed out";
+    else message = "Reference Kernel execution failed with code " + to_string(ref_result);
+    message += context;
 
-        // Generate the backend specific kernel
-        fs::path backend_kernel = iter_dir / "backend_kernel";
-        fs::create_directories(backend_kernel);
-        bool gen_ok = target_backend->generate_kernel(mutated_file_names, backend_kernel);
-        if (!gen_ok) {
-            cerr << "generate_kernel failed for iter " << iter_id << "\n";
-            LOG_WARN("generate_kernel failed for iter " + iter_id + " to generate mutated backend kernels.");
-            return;
-        }
+    LOG_INFO(message + ": " + it.iter_id);
+    archive_failure_case(it.iter_dir.stem().string(), it.iter_dir / "kernel", it.fail_dir / "ref_crash", message);
+}
 
-        // Run reference executor (trusted) once to produce expected outputs
-        uint64_t timeout = executor_timeout_ms; // Use CLI-defined timeout
-        fs::path ref_out_dir = iter_data_dir / "ref_out";
-        fs::create_directories(ref_out_dir);
-        
-        // Use the generated reference kernel path
-        // TODO: Make it generic
-        string ref_kernel_filename = (backend_kernel / "kernel/backend_kernel.cpp");
+// --reference native: compute the reference output in-process from the input data,
+// instead of executing the reference kernel
+static bool run_native_reference(FuzzIteration& it) {
+    try {
+        evaluate_kernel(it.kernels[0], it.ref_out_file().string());
+    } catch (const std::exception& e) {
+        LOG_ERROR("Native reference failed for " + it.iter_id + ": " + e.what());
+        return false;
+    }
+    it.results[0] = 0;
+    return true;
+}
+
+// Stage 4: execute the reference once, then the mutants up to the first crash
+static bool stage_execute(FuzzIteration& it, const FuzzConfig& cfg) {
+    FuzzBackend* target_backend = cfg.backend;
+    it.results.assign(it.kernel_paths.size(), std::nullopt);
+    it.equal.assign(it.kernel_paths.size(), std::nullopt);
 
-        int ref_result = run_with_timeout(target_backend, ref_kernel_filename, "", timeout);
+    // Run reference executor (trusted) once to produce expected outputs
+    uint64_t timeout = cfg.executor_timeout_ms; // Use CLI-defined timeout
+    fs::path ref_out_dir = it.iter_data_dir / "ref_out";
+    fs::create_directories(ref_out_dir);
+
+    // Batch mode: execute the reference and every mutant in one go, then consume the
+    // statuses below. Anything the batch could not settle is executed individually.
+    vector<optional<int>> batch_results;
+    if (cfg.batch_execution && target_backend->supports_batch()) {
+        // The native reference is not part of the batch
+        size_t first = cfg.native_reference ? 1 : 0;
+        if (first) batch_results.push_back(nullopt);
+        vector<fs::path> batch_paths(it.kernel_paths.begin() + first, it.kernel_paths.end());
+        for (int status : run_batch_with_timeout(target_backend, batch_paths, "", it.clip_timeout(timeout))) {
+            batch_results.push_back(status == -2 ? optional<int>() : optional<int>(status));
+        }
+    }
+    // A failed ahead-of-time build is the kernel's result; a build that timed out is retried by execution
+    auto take_result = [&](size_t mi) -> optional<int> {
+        if (mi < it.compile_status.size() && it.compile_status[mi] != 0 && it.compile_status[mi] != -2) {
+            return it.compile_status[mi];
+        }
+        if (mi >= batch_results.size()) return nullopt;
+        optional<int> result = batch_results[mi];
+        batch_results[mi].reset();
+        return result;
+    };
+
+    if (cfg.native_reference) {
+        if (!run_native_reference(it)) return false;
+    } else {
+        optional<int> ref_early_result = take_result(0);
+        int ref_result = ref_early_result ? *ref_early_result : run_with_timeout(target_backend, it.kernel_paths[0].string(), "", it.clip_timeout(timeout));
+        it.results[0] = ref_result;
 
         if (ref_result != 0) {
-            g_ref_crash_count++;
-            std::string message;
-            if (ref_result == -2) message = "Reference Kernel execution timed out";
-            else message = "Reference Kernel execution failed with code " + to_string(ref_result);
-            
-            LOG_INFO(message + ": " + iter_id);
-            archive_failure_case(iter_dir.stem().string(), iter_dir / "kernel", fail_dir / "ref_crash", message);
-            return; 
-        }
-
-        // Run target on each mutant and compare outputs
-        LOG_INFO("Running mutants...");
-        
-        // Path to the reference result output file
-        string ref_out_file = (ref_out_dir / "results.tns").string();
-        
-        for (size_t mi = 1; mi < mutated_file_names.size() && !g_terminate; ++mi) {
-            fs::path mutant_path = backend_kernel / ("kernel" + to_string(mi)) / "backend_kernel.cpp";
-            
-            // Run target backend on the mutated kernel
-            int result = run_with_timeout(target_backend, mutant_path.string(), "", timeout);
-            
-            if (result != 0) {
-                // Crashing bug or timeout
-                if (result == -2) {
-                    // Timeout: Increase timeout and retry this mutant
-                    timeout += 4000;
-                    mi--; // Decrement to retry the current mutant
-                    continue;
+            // Cut short by the time budget rather than hanging
+            if (ref_result == -2 && !within_time_budget(it, cfg)) return false;
+            if (ref_result == PROCESS_OUT_OF_MEMORY) {
+                LOG_WARN("Reference of " + it.iter_id + " ran out of the memory budget, skipping");
+                return false;
+            }
+            archive_ref_crash(it, ref_result, "");
+            return false;
+        }
+    }
+
+    // Run target on each mutant
+    LOG_INFO("Running mutants...");
+
+    if (cfg.mutant_pool) {
+        std::atomic<bool> cancel = false;
+        // Waiting here runs queued sub-tasks (this iteration's or another's) on this thread
+        TaskGroup group(*cfg.mutant_pool, TaskPriority::High);
+        for (size_t mi = 1; mi < it.kernel_paths.size() && !cancel && !g_terminate; ++mi) {
+            group.run([&it, &cfg, mi, &cancel]() { run_mutant_task(it, cfg, mi, cancel); });
+        }
+        group.wait();
+        return true;
+    }
+
+    int timeout_retries = 0;
+    for (size_t mi = 1; mi < it.kernel_paths.size() && !g_terminate; ++mi) {
+        // Out of time: the mutants executed so far are still compared
+        if (!within_time_budget(it, cfg)) break;
+
+        // Run target backend on the mutated kernel
+        optional<int> early_result = take_result(mi);
+        int result = early_result ? *early_result : run_mutant(it, cfg, mi, timeout);
+
+        if (result == -2) {
+            if (timeout_retries < MAX_TIMEOUT_RETRIES) {
+                // Timeout: Increase timeout and retry this mutant
+                timeout_retries++;
+                timeout += TIMEOUT_RETRY_INCREMENT_MS;
+                mi--; // Decrement to retry the current mutant
+                continue;
+            }
+            // Still hanging: give up on this mutant rather than holding the worker
+            LOG_WARN("Mutant " + to_string(mi) + " of " + it.iter_id + " timed out after " + to_string(timeout) + " ms, skipping");
+            timeout_retries = 0;
+            timeout = cfg.executor_timeout_ms;
+            continue;
+        }
+        timeout_retries = 0;
+        if (result == PROCESS_OUT_OF_MEMORY) {
+            LOG_WARN("Mutant " + to_string(mi) + " of " + it.iter_id + " ran out of the memory budget, skipping");
+            continue;
+        }
+        it.results[mi] = result;
+
+        // Crashing bug: the mutants after it are not needed
+        if (result != 0) break;
+    }
+    return true;
+}
+
+// Stage 5: compare the mutants' outputs against the reference, archive the first crash or wrong-code
+static bool stage_compare(FuzzIteration& it, const FuzzConfig& cfg) {
+    bool found = false;
+    for (size_t mi = 1; mi < it.kernel_paths.size() && !g_terminate; ++mi) {
+        if (!it.results[mi]) continue;  // timed out or not executed
+        fs::path mutant_path = it.kernel_paths[mi];
+        int result = *it.results[mi];
+
+        if (result != 0) {
+            // Actual Crashing Bug
+            g_crash_bug_count++;
+            LOG_INFO("CRASHING BUG FOUND IN MUTANT " + to_string(mi) + " of " + it.iter_id);
+            archive_failure_case(it.iter_id, mutant_path.parent_path(), it.fail_dir / "crash", "Mutated Kernel execution failed with code " + to_string(result));
+            found = true;
+            break; // don't break, if you want to check whether other mutants also induce bugs
+        }
+
+        // Compare the results for a wrong code bug (parallel and streamed mutants have compared already).
+        // A mutant whose results cannot be read back (e.g. its rerun for the full results timed out) is skipped.
+        string mutant_out_file = mutant_path.parent_path() / "results.tns";
+        bool equal;
+        try {
+            equal = (mi < it.equal.size() && it.equal[mi]) ? *it.equal[mi] : it.comparison(cfg.backend, mi, it.clip_timeout(cfg.executor_timeout_ms)).compare(mutant_out_file);
+        } catch (const std::exception& e) {
+            LOG_WARN("Mutant " + to_string(mi) + " of " + it.iter_id + " could not be compared (" + e.what() + "), skipping");
+            continue;
+        }
+
+        if (!equal) {
+            LOG_INFO("WRONG CODE BUG FOUND IN MUTANT " + to_string(mi) + " of " + it.iter_id);
+            g_wrong_code_count++;
+            archive_failure_case(it.iter_id, mutant_path.parent_path(), it.fail_dir / "wc", "Mutated Kernel produced incorrect results.");
+            found = true;
+            break; // don't break, if you want to check whether other mutants also induce bugs
+        }
+    }
+
+    // Logging for progress
+    if (it.iter % 100 == 0) {
+        LOG_INFO("Completed iteration " + to_string(it.iter));
+        std::cout << "Iteration " << it.iter << " OK. Runs/sec: " << (g_completed_runs.load() / std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count()) << endl;
+    }
+    return !found;
+}
+
+// Stage 6 (--data-variants): execute the same kernels again on new inputs. Odd variants keep
+// the shapes and draw new data; even ones also draw new index extents (draw_index_extents),
+// redrawn a few times if they would take a member's dense levels past the bound.
+// The backend rebinds its kernels to the inputs, so nothing is generated or built again.
+// Data mutants have inputs of their own and are left out.
+static bool stage_variants(FuzzIteration& it, const FuzzConfig& cfg) {
+    if (cfg.data_variants == 0) return true;
+
+    const tsKernel& ref = it.kernels[0];
+    std::vector<size_t> members;
+    for (size_t ki = 0; ki < it.kernel_paths.size(); ++ki) {
+        if (ki == 0 || (it.results[ki] == 0 && it.output_transforms[ki].empty() && it.kernels[ki].dataFileNames == ref.dataFileNames)) {
+            members.push_back(ki);
+        }
+    }
+
+    std::map<char, int> dims;
+    for (auto& tensor : ref.tensors) {
+        for (size_t m = 0; m < tensor.idxs.size(); ++m) dims[tensor.idxs[m]] = tensor.shape[m];
+    }
+
+    // Whether the dense levels of every member stay within the bound under extents
+    auto dense_levels_fit_all = [&](const std::map<char, int>& extents) {
+        for (size_t ki : members) {
+            for (tsTensor tensor : it.kernels[ki].tensors) {
+                tensor.shape.clear();
+                for (char idx : tensor.idxs) tensor.shape.push_back(extents.at(idx));
+                if (!dense_levels_fit(tensor, cfg.generator.max_dense_volume)) return false;
+            }
+        }
+        return true;
+    };
+
+    for (size_t v = 1; v <= cfg.data_variants && !g_terminate && within_time_budget(it, cfg); ++v) {
+        for (int attempt = 0; v % 2 == 0 && attempt < 10; ++attempt) {
+            std::map<char, int> extents = draw_index_extents(ref.tensors, cfg.generator, it.rng);
+            if (dense_levels_fit_all(extents)) {
+                dims = extents;
+                break;
+            }
+        }
+
+        std::vector<tsTensor> tensors = ref.tensors;
+        for (auto& tensor : tensors) {
+            tensor.shape.clear();
+            for (char idx : tensor.idxs) tensor.shape.push_back(dims.at(idx));
+        }
+        fs::path variant_dir = it.iter_data_dir / ("variant" + to_string(v));
+        std::vector<std::string> datafile_names = generate_random_tensor_data(tensors, variant_dir.string(), "", cfg.tensor_file_format, cfg.generator);
+        if (datafile_names.size() != tensors.size() - 1) {
+            LOG_ERROR("Tensor data generation failed for variant " + to_string(v) + " of " + it.iter_id);
+            return false;
+        }
+
+        std::string extents;
+        for (auto& [idx, dim] : dims) extents += (extents.empty() ? "" : ",") + std::string(1, idx) + "=" + to_string(dim);
+        std::string context = " on data variant " + to_string(v) + " (" + extents + ")";
+
+        for (size_t ki : members) {
+            tsKernel& kernel = it.kernels[ki];
+            for (auto& tensor : kernel.tensors) {
+                tensor.shape.clear();
+                for (char idx : tensor.idxs) tensor.shape.push_back(dims.at(idx));
+            }
+            for (size_t ti = 1; ti < tensors.size(); ++ti) {
+                std::string name(1, tensors[ti].name);
+                if (kernel.dataFileNames.count(name)) kernel.dataFileNames[name] = datafile_names[ti - 1];
+            }
+            if (ki == 0 && cfg.native_reference) continue;
+            if (!cfg.backend->rebind_kernel(it.kernel_paths[ki], kernel)) {
+                LOG_WARN("Backend could not rebind kernel " + to_string(ki) + " of " + it.iter_id + " to new inputs");
+                return true;
+            }
+        }
+
+        uint64_t timeout = cfg.executor_timeout_ms;
+        if (cfg.native_reference) {
+            if (!run_native_reference(it)) return false;
+        } else {
+            int ref_result = run_with_timeout(cfg.backend, it.kernel_paths[0].string(), "", it.clip_timeout(timeout));
+            if (ref_result != 0) {
+                if (ref_result == -2 && !within_time_budget(it, cfg)) return false;
+                if (ref_result == PROCESS_OUT_OF_MEMORY) {
+                    LOG_WARN("Reference of " + it.iter_id + " ran out of the memory budget" + context + ", skipping");
+                    return false;
+                }
+                archive_ref_crash(it, ref_result, context);
+                return false;
+            }
+        }
+
+        std::unique_ptr<ComparisonSession> session = cfg.backend->open_comparison(it.ref_out_file().string(), it.clip_timeout(timeout));
+        for (size_t ki : members) {
+            if (ki == 0 || g_terminate) continue;
+            if (!within_time_budget(it, cfg)) return false;
+            const fs::path& mutant_path = it.kernel_paths[ki];
+            std::string mutant_out_file = mutant_path.parent_path() / "results.tns";
+
+            bool equal = false;
+            int result;
+            try {
+                if (cfg.stream_compare) {
+                    result = cfg.backend->execute_and_compare(mutant_path, "", it.clip_timeout(timeout), *session, mutant_out_file, equal);
+                } else {
+                    result = run_with_timeout(cfg.backend, mutant_path.string(), "", it.clip_timeout(timeout));
+                    if (result == 0) equal = session->compare(mutant_out_file);
                 }
-                // Actual Crashing Bug
+            } catch (const std::exception& e) {
+                LOG_WARN("Mutant " + to_string(ki) + " of " + it.iter_id + " could not be compared" + context + " (" + e.what() + "), skipping");
+                continue;
+            }
+
+            if (result == -2) {
+                LOG_WARN("Mutant " + to_string(ki) + " of " + it.iter_id + " timed out" + context + ", skipping");
+                continue;
+            }
+            if (result == PROCESS_OUT_OF_MEMORY) {
+                LOG_WARN("Mutant " + to_string(ki) + " of " + it.iter_id + " ran out of the memory budget" + context + ", skipping");
+                continue;
+            }
+            if (result != 0) {
                 g_crash_bug_count++;
-                LOG_INFO("CRASHING BUG FOUND IN MUTANT " + to_string(mi) + " of " + iter_id);
-                archive_failure_case(iter_id, mutant_path.parent_path(), fail_dir / "crash", "Mutated Kernel execution failed with code " + to_string(result));
-                break; // don't break, if you want to check whether other mutants also induce bugs
-            } 
-            
-            // Compare the results for a wrong code bug
-            string ref_out_file = (iter_data_dir / "ref_out" / "results.tns").string();
-            string mutant_out_file = mutant_path.parent_path() / "results.tns";
-            bool equal = target_backend->compare_results(ref_out_file, mutant_out_file);
-            
+                LOG_INFO("CRASHING BUG FOUND IN MUTANT " + to_string(ki) + " of " + it.iter_id + context);
+                archive_failure_case(it.iter_id, mutant_path.parent_path(), it.fail_dir / "crash", "Mutated Kernel execution failed with code " + to_string(result) + context);
+                return false;
+            }
             if (!equal) {
-                LOG_INFO("WRONG CODE BUG FOUND IN MUTANT " + to_string(mi) + " of " + iter_id);
                 g_wrong_code_count++;
-                archive_failure_case(iter_id, mutant_path.parent_path(), fail_dir / "wc", "Mutated Kernel produced incorrect results.");
-                break; // don't break, if you want to check whether other mutants also induce bugs
+                LOG_INFO("WRONG CODE BUG FOUND IN MUTANT " + to_string(ki) + " of " + it.iter_id + context);
+                archive_failure_case(it.iter_id, mutant_path.parent_path(), it.fail_dir / "wc", "Mutated Kernel produced incorrect results" + context + ".");
+                return false;
             }
         }
-        
-        // Logging for progress
-        if (iter % 100 == 0) {
-            LOG_INFO("Completed iteration " + to_string(iter));
-            std::cout << "Iteration " << iter << " OK. Runs/sec: " << (g_completed_runs.load() / std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count()) << endl;
-        }
 
+        // Passed: its data is not needed for an archive
+        std::error_code ec;
+        fs::remove_all(variant_dir, ec);
+    }
+    return true;
+}
+
+// Run one stage of an iteration; false ends the iteration (failure found, error or termination)
+static bool run_stage(FuzzIteration& it, const FuzzConfig& cfg, FuzzStage stage) {
+    if (g_terminate) return false;
+    // Time spent queued for this stage (--pipeline back-pressure) is not the iteration's own
+    if (it.deadline && it.stage_done) *it.deadline += std::chrono::steady_clock::now() - *it.stage_done;
+    // Out of time, only the comparison of what was executed is left to do
+    if (stage != stage_compare && !within_time_budget(it, cfg)) return false;
+    bool ok;
+    try {
+        ok = stage(it, cfg);
     } catch (const std::exception &e) {
         // Exception in the fuzzing pipeline (e.g., file system error, generator failure)
-        cerr << "Exception in iteration " << iter << ": " << e.what() << std::endl;
-        LOG_ERROR("Pipeline exception in iter " + std::to_string(iter) + ": " + e.what());
+        cerr << "Exception in iteration " << it.iter << ": " << e.what() << std::endl;
+        LOG_ERROR("Pipeline exception in iter " + std::to_string(it.iter) + ": " + e.what());
+        ok = false;
     }
+    it.stage_done = std::chrono::steady_clock::now();
+    return ok;
+}
+
+static const std::vector<std::pair<std::string, FuzzStage>> FUZZ_STAGES = {
+    {"generate", stage_generate},
+    {"kernel", stage_backend_kernels},
+    {"compile", stage_compile},
+    {"execute", stage_execute},
+    {"compare", stage_compare},
+    {"variants", stage_variants},
+};
+
+/**
+ * @brief The core fuzzing task executed by a single worker thread: every stage in turn.
+ */
+void FuzzingJob(size_t iter, std::mt19937::result_type seed_offset, const FuzzConfig& cfg) {
+    if (g_terminate) return;
+
+    FuzzIteration it(iter, seed_offset, cfg.out_root);
+    for (auto& [name, stage] : FUZZ_STAGES) {
+        if (!run_stage(it, cfg, stage)) break;
+    }
+}
+
+// --scale-dims: "lo:hi,..." rungs of index extents, a single n being the rung n:n
+static std::vector<std::pair<int, int>> parse_dim_ladder(const std::string& arg) {
+    std::vector<std::pair<int, int>> ladder;
+    std::stringstream ss(arg);
+    string item;
+    while (std::getline(ss, item, ',')) {
+        size_t colon = item.find(':');
+        int lo = stoi(item.substr(0, colon));
+        ladder.push_back({lo, colon == string::npos ? lo : stoi(item.substr(colon + 1))});
+    }
+    return ladder;
+}
+
+// --scale-density: "d,..." densities of the inputs
+static std::vector<double> parse_density_ladder(const std::string& arg) {
+    std::vector<double> ladder;
+    std::stringstream ss(arg);
+    string item;
+    while (std::getline(ss, item, ',')) ladder.push_back(stod(item));
+    return ladder;
 }
 
 // ---------- Program entry ----------
@@ -327,6 +896,16 @@ int main(int argc, char* argv[]) {
     string backend_so;
     uint64_t executor_timeout_ms = 30'000;
     string tensor_file_format = "tns";
+    bool batch_execution = false;
+    bool pipeline_mode = false;
+    bool parallel_mutants = false;
+    bool stream_compare = false;
+    bool native_reference = false;
+    size_t data_variants = 0;
+    std::map<std::string, size_t> stage_workers;   // --stage-workers overrides, by stage name
+    // Large-scale mode: any of these switches it on; flags override the config file
+    string scale_config, scale_dims, scale_density;
+    std::optional<uint64_t> memory_budget_mb, time_budget_ms;
     // read CLI args simply
     for (int i = 1; i < argc; ++i) {
         string s = argv[i];
@@ -334,13 +913,52 @@ int main(int argc, char* argv[]) {
             backend_so = argv[++i];
         } else if ((s == "--timeout") && i + 1 < argc) {
             executor_timeout_ms = stoull(argv[++i]);
+        } else if (s == "--batch") {
+            batch_execution = true;
+        } else if (s == "--parallel-mutants") {
+            parallel_mutants = true;
+        } else if (s == "--reference" && i + 1 < argc) {
+            string source = argv[++i];
+            if (source == "native" || source == "backend") {
+                native_reference = source == "native";
+            } else {
+                cerr << "Unknown reference source: " << source << "\n";
+            }
+        } else if (s == "--data-variants" && i + 1 < argc) {
+            data_variants = stoull(argv[++i]);
+        } else if (s == "--scale-config" && i + 1 < argc) {
+            scale_config = argv[++i];
+        } else if (s == "--scale-dims" && i + 1 < argc) {
+            scale_dims = argv[++i];
+        } else if (s == "--scale-density" && i + 1 < argc) {
+            scale_density = argv[++i];
+        } else if (s == "--memory-budget" && i + 1 < argc) {
+            memory_budget_mb = stoull(argv[++i]);
+        } else if (s == "--time-budget" && i + 1 < argc) {
+            time_budget_ms = stoull(argv[++i]);
+        } else if (s == "--stream-compare") {
+            stream_compare = true;
+        } else if (s == "--pipeline") {
+            pipeline_mode = true;
+        } else if (s == "--stage-workers" && i + 1 < argc) {
+            // e.g. compile=2,execute=8
+            std::stringstream ss(argv[++i]);
+            string item;
+            while (std::getline(ss, item, ',')) {
+                size_t eq = item.find('=');
+                if (eq == string::npos) {
+                    cerr << "Malformed --stage-workers entry: " << item << "\n";
+                    continue;
+                }
+                stage_workers[item.substr(0, eq)] = stoull(item.substr(eq + 1));
+            }
         } else if ((s == "--tensor-format" || s == "--tfmt") && i + 1 < argc) {
             string user_tfmt = argv[++i];
             std::transform(user_tfmt.begin(), user_tfmt.end(), user_tfmt.begin(), 
                             [](unsigned char c) { 
                                 return std::tolower(c); 
                             });
-            if (user_tfmt != "tns" && user_tfmt != "ttx")
+            if (user_tfmt != "tns" && user_tfmt != "ttx" && user_tfmt != "bin")
             {
                 cerr << "Unsupported tensor storage format: " << user_tfmt << "\n";
             } else {
@@ -361,6 +979,32 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    GeneratorConfig generator;
+    if (!scale_config.empty() || !scale_dims.empty() || !scale_density.empty()) {
+        generator = GeneratorConfig::large_scale();
+        try {
+            if (!scale_config.empty()) {
+                std::ifstream in(scale_config);
+                if (!in.is_open()) throw std::runtime_error("Cannot open " + scale_config);
+                json j;
+                in >> j;
+                generator.fromJson(j);
+                if (!memory_budget_mb && j.contains("memoryBudgetMb")) memory_budget_mb = j["memoryBudgetMb"].get<uint64_t>();
+                if (!time_budget_ms && j.contains("timeBudgetMs")) time_budget_ms = j["timeBudgetMs"].get<uint64_t>();
+            }
+            if (!scale_dims.empty()) generator.dim_ladder = parse_dim_ladder(scale_dims);
+            if (!scale_density.empty()) generator.density_ladder = parse_density_ladder(scale_density);
+            generator.validate();
+        } catch (const std::exception& e) {
+            cerr << "Invalid large-scale configuration: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // Read by every supervised process start, including the backend's (see tensure/process.hpp);
+    // set before any thread runs
+    if (memory_budget_mb.value_or(0) > 0) setenv(MEMORY_LIMIT_ENV, to_string(*memory_budget_mb).c_str(), 1);
+
     // signal handling
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
@@ -404,38 +1048,141 @@ int main(int argc, char* argv[]) {
 
     const size_t num_threads = std::thread::hardware_concurrency();
     size_t actual_threads = (num_threads == 0) ? 4 : num_threads;
-    std::cout << "Starting Thread Pool with " << actual_threads << " workers.\n";
-
-    ThreadPool pool(actual_threads);
-
-    // The Producer Loop: Queues tasks up to max_iterations
-    for (size_t iter = 0; iter < max_iterations && !g_terminate; ++iter) {
-        
-        // Enqueue the fuzzing job (wrapped in a lambda)
-        // We capture shared read-only pointers and config by value/reference.
-        // We pass the RNG seed offset (iter) instead of the RNG object itself.
-        pool.enqueue([=, &out_root]() mutable {
-            FuzzingJob(iter, target_backend, rng(), out_root, tensor_file_format, executor_timeout_ms);
+
+    FuzzConfig cfg;
+    cfg.backend = target_backend;
+    cfg.out_root = out_root;
+    cfg.tensor_file_format = tensor_file_format;
+    cfg.executor_timeout_ms = executor_timeout_ms;
+    cfg.batch_execution = batch_execution;
+
+    if (parallel_mutants && batch_execution) {
+        cerr << "--parallel-mutants has no effect with --batch\n";
+        parallel_mutants = false;
+    }
+    if (stream_compare && batch_execution) {
+        cerr << "--stream-compare has no effect with --batch\n";
+        stream_compare = false;
+    }
+    if (stream_compare && !target_backend->supports_streaming()) {
+        cerr << "The backend does not stream outputs, --stream-compare has no effect\n";
+        stream_compare = false;
+    }
+    cfg.stream_compare = stream_compare;
+    cfg.native_reference = native_reference;
+
+    if (data_variants > 0 && !target_backend->supports_rebinding()) {
+        cerr << "The backend cannot rebind kernels to new inputs, --data-variants has no effect\n";
+        data_variants = 0;
+    }
+    cfg.data_variants = data_variants;
+    cfg.generator = generator;
+    cfg.time_budget_ms = time_budget_ms.value_or(0);
+
+    if (generator.stream) {
+        std::ostringstream desc;
+        desc << "Large-scale mode: extents";
+        for (auto [lo, hi] : generator.dim_ladder) desc << " " << lo << ":" << hi;
+        desc << ", densities";
+        for (double density : generator.density_ladder) desc << " " << density;
+        desc << ", at most " << generator.max_nnz << " nonzeros per input";
+        std::cout << desc.str() << "\n";
+        LOG_INFO(desc.str());
+    }
+    if (memory_budget_mb.value_or(0) > 0) LOG_INFO("Memory budget per kernel process: " + to_string(*memory_budget_mb) + " MB");
+    if (cfg.time_budget_ms > 0) LOG_INFO("Time budget per iteration: " + to_string(cfg.time_budget_ms) + " ms");
+
+    // Every iteration derives its RNG from this offset and its index
+    const std::mt19937::result_type seed_offset = rng();
+
+    // Monitoring Loop (Kept as is); scheduler_report() adds a line on the pool or pipeline stages
+    auto monitor = [&](const std::function<string()>& scheduler_report) {
+        size_t last_count = 0;
+        while (g_completed_runs < max_iterations && !g_terminate) {
+            std::this_thread::sleep_for(std::chrono::seconds(10));
+            size_t current_count = g_completed_runs.load();
+            size_t rate = (current_count - last_count) / 10;
+            std::cout << "Progress: " << current_count << " / " << max_iterations 
+                      << " | Rate: " << rate << " runs/sec";
+            string backend_stats = target_backend->stats();
+            if (!backend_stats.empty()) std::cout << " | " << backend_stats;
+            std::cout << "\n";
+            if (scheduler_report) {
+                string report = scheduler_report();
+                std::cout << report << "\n";
+                LOG_INFO(report);
+            }
+            last_count = current_count;
+        }
+    };
+
+    if (pipeline_mode) {
+        // Each stage gets its own workers, so e.g. a handful of compilers run next to many
+        // executions while generation of the next iterations overlaps with both
+        std::map<std::string, size_t> default_workers = {
+            {"generate", 1},
+            {"kernel", 1},
+            {"compile", std::max<size_t>(1, actual_threads / 4)},
+            {"execute", actual_threads},
+            {"compare", 1},
+            {"variants", actual_threads},
+        };
+        for (auto& [name, workers] : stage_workers) {
+            if (!default_workers.count(name)) cerr << "Unknown pipeline stage: " << name << "\n";
+        }
+
+        // Mutant sub-tasks get their own pool; execute workers help it while they wait.
+        // Declared before the pipeline so it outlives every stage worker.
+        std::unique_ptr<ThreadPool> mutant_pool;
+        if (parallel_mutants) {
+            mutant_pool = std::make_unique<ThreadPool>(actual_threads);
+            cfg.mutant_pool = mutant_pool.get();
+        }
+
+        Pipeline<std::unique_ptr<FuzzIteration>> pipeline;
+        for (auto& [name, stage] : FUZZ_STAGES) {
+            size_t workers = stage_workers.count(name) ? stage_workers[name] : default_workers[name];
+            std::cout << "Stage " << name << ": " << workers << " workers.\n";
+            FuzzStage fn = stage;
+            pipeline.add_stage(name, workers, 2 * workers, [fn, &cfg](std::unique_ptr<FuzzIteration>& it) {
+                return run_stage(*it, cfg, fn);
+            });
+        }
+        pipeline.start();
+
+        // submit() blocks while the first stage is saturated
+        std::thread producer([&]() {
+            for (size_t iter = 0; iter < max_iterations && !g_terminate; ++iter) {
+                pipeline.submit(std::make_unique<FuzzIteration>(iter, seed_offset, out_root));
+            }
+            std::cout << "All fuzzing jobs successfully queued.\n";
         });
 
-        // Throttle the producer if too far ahead (optional, but prevents massive queueing if workers are slow)
-        // Check if the number of tasks in the queue exceeds a safe threshold (e.g., 2x threads)
-        while ((iter - g_completed_runs.load()) > actual_threads * 2 && !g_terminate) {
-             std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        monitor([&pipeline]() { return "Stages: " + pipeline.occupancy(); });
+        producer.join();
+        pipeline.finish();
+    } else {
+        std::cout << "Starting Thread Pool with " << actual_threads << " workers.\n";
+
+        // enqueue() blocks once 2x threads iterations are waiting, which throttles the producer
+        ThreadPool pool(actual_threads, actual_threads * 2);
+        // Mutant sub-tasks are queued as High, ahead of new iterations
+        if (parallel_mutants) cfg.mutant_pool = &pool;
+
+        // The Producer Loop: Queues tasks up to max_iterations
+        for (size_t iter = 0; iter < max_iterations && !g_terminate; ++iter) {
+            
+            // Enqueue the fuzzing job (wrapped in a lambda)
+            // We capture shared read-only pointers and config by value/reference.
+            // We pass the RNG seed offset (iter) instead of the RNG object itself.
+            pool.enqueue([iter, seed_offset, &cfg]() {
+                FuzzingJob(iter, seed_offset, cfg);
+            }, TaskPriority::Normal);
         }
-    }
 
-    std::cout << "All fuzzing jobs successfully queued.\n";
+        std::cout << "All fuzzing jobs successfully queued.\n";
 
-    // Monitoring Loop (Kept as is)
-    size_t last_count = 0;
-    while (g_completed_runs < max_iterations && !g_terminate) {
-        std::this_thread::sleep_for(std::chrono::seconds(10));
-        size_t current_count = g_completed_runs.load();
-        size_t rate = (current_count - last_count) / 10;
-        std::cout << "Progress: " << current_count << " / " << max_iterations 
-                  << " | Rate: " << rate << " runs/sec\n";
-        last_count = current_count;
+        monitor([&pool]() { return "Pool: " + pool.metrics().to_string(); });
     }
 
     std::cout << "Fuzzing loop finished (terminated=" << g_terminate << ")\n";
@@ -443,6 +1190,7 @@ int main(int argc, char* argv[]) {
     LOG_INFO("Total reference program crash iteration: " + to_string(g_ref_crash_count));
     LOG_INFO("Total Crashing bugs: " + to_string(g_crash_bug_count));
     LOG_INFO("Total Wrong Code bugs: " + to_string(g_wrong_code_count));
+    LOG_INFO("Total iterations over their time budget: " + to_string(g_over_budget_count));
     LOG_INFO("Total Valid Einsum Generated: " + to_string(g_valid_einsum_count));
     LOG_INFO("Fuzzing loop finished (terminated=" + to_string(g_terminate));
 
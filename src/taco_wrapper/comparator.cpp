@@ -1,78 +1,159 @@
 #include "taco_wrapper/comparator.hpp"
 
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace taco_wrapper {
 
 using namespace std;
 
-struct VecHash {
-    size_t operator()(const std::vector<int>& v) const noexcept {
-        size_t h = 0;
-        for (int x : v) {
-            h = h * 1315423911u + std::hash<int>()(x);
-        }
-        return h;
-    }
-};
-
 bool compare_outputs(const std::string& ref_output,
                      const std::string& kernel_output,
                      double tol)
 {
-    auto read_tensor = [&](const std::string& path) {
-        std::unordered_map<std::vector<int>, double, VecHash> data;
+    TensorMismatch mismatch;
+    if (compare_tensor_files(ref_output, kernel_output, tol, &mismatch))
+        return true;
 
-        std::ifstream file(path);
-        if (!file.is_open()) {
-            throw std::runtime_error("Cannot open " + path);
-        }
+    LOG_INFO("Output mismatch at " + mismatch.to_string() + " (" + kernel_output + ")");
+    return false;
+}
 
-        std::string line;
-        while (std::getline(file, line)) {
-            if (line.empty()) continue;
+// A results file, or the fingerprint written instead of it
+static bool results_exist(const fs::path& p)
+{
+    return fs::exists(p) || fs::exists(fingerprint_file_of(p.string()));
+}
 
-            std::istringstream iss(line);
-            std::vector<std::string> toks;
-            std::string tok;
+std::string resolve_results_file(const std::string& path)
+{
+    fs::path p = path;
+    if (!results_exist(p) && p.extension() == ".tns") {
+        fs::path bin_path = fs::path(p).replace_extension(".bin");
+        if (results_exist(bin_path)) return bin_path.string();
+    }
+    return path;
+}
 
-            while (iss >> tok) {
-                toks.push_back(tok);
-            }
+ReferenceComparison::ReferenceComparison(const std::string& ref_output, double tol, FullResultsWriter write_full_results)
+    : ref_file(resolve_results_file(ref_output)), tol(tol), write_full_results(std::move(write_full_results))
+{
+    if (!fs::exists(ref_file)) {
+        throw std::runtime_error("Reference output not found: " + ref_file);
+    }
+    // Fingerprints only match when taken at the tolerance outputs are compared at
+    has_ref_fp = read_fingerprint_file(fingerprint_file_of(ref_file), ref_fp) && ref_fp.tol == tol;
+}
 
-            if (toks.size() < 2)
-                continue; // ignore garbage lines
+const ReferenceTensor& ReferenceComparison::reference()
+{
+    std::call_once(ref_once, [&] { ref = std::make_unique<ReferenceTensor>(ref_file); });
+    return *ref;
+}
 
-            double val = std::stod(toks.back());
-            if (val == 0.0)
-                continue; // skip zeros entirely
+bool ReferenceComparison::compare(const std::string& kernel_output)
+{
+    std::string out_file = resolve_results_file(kernel_output);
 
-            std::vector<int> coords;
-            coords.reserve(toks.size() - 1);
-            for (size_t i = 0; i + 1 < toks.size(); ++i) {
-                coords.push_back(std::stoi(toks[i]));
-            }
+    OutputFingerprint out_fp;
+    if (has_ref_fp && read_fingerprint_file(fingerprint_file_of(out_file), out_fp) && out_fp == ref_fp)
+        return true;
 
-            data.emplace(std::move(coords), val);
-        }
+    // The fingerprints differ (or a value sits at a rounding boundary): compare the files
+    if (!fs::exists(out_file) && write_full_results && !write_full_results(out_file)) {
+        throw std::runtime_error("Failed to write the full results " + out_file);
+    }
 
-        return data;
-    };
+    TensorMismatch mismatch;
+    if (reference().compare(out_file, tol, &mismatch))
+        return true;
 
-    auto ref = read_tensor(ref_output);
-    auto out = read_tensor(kernel_output);
+    LOG_INFO("Output mismatch at " + mismatch.to_string() + " (" + out_file + ")");
+    return false;
+}
 
-    if (ref.size() != out.size())
-        return false;
+bool ReferenceComparison::supports_streaming()
+{
+    return reference().supports_streaming();
+}
 
-    for (auto& [coords, val_ref] : ref) {
-        auto it = out.find(coords);
-        if (it == out.end())
-            return false;
+int ReferenceComparison::compare_streamed(const std::string& fifo_path, const std::function<int(const std::string&)>& run_kernel, bool& equal)
+{
+    const ReferenceTensor& ref_tensor = reference();
 
-        if (std::fabs(it->second - val_ref) > tol)
-            return false;
+    fs::remove(fifo_path);
+    if (mkfifo(fifo_path.c_str(), 0600) != 0) {
+        throw std::runtime_error("Cannot create FIFO " + fifo_path + ": " + strerror(errno));
     }
-
-    return true;
+    // The read end is opened first, so neither open blocks. Holding a write end until the
+    // kernel has exited keeps read() from reporting end of file before the kernel opened it.
+    int read_fd = open(fifo_path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    int hold_fd = read_fd >= 0 ? open(fifo_path.c_str(), O_WRONLY | O_CLOEXEC) : -1;
+    if (hold_fd < 0) {
+        std::string error = strerror(errno);
+        if (read_fd >= 0) close(read_fd);
+        fs::remove(fifo_path);
+        throw std::runtime_error("Cannot open FIFO " + fifo_path + ": " + error);
+    }
+    fcntl(read_fd, F_SETFL, fcntl(read_fd, F_GETFL) & ~O_NONBLOCK);
+
+    int status = -1;
+    std::thread kernel([&] {
+        try {
+            status = run_kernel(fifo_path);
+        } catch (const std::exception& e) {
+            LOG_ERROR(std::string("Exception from streamed kernel: ") + e.what());
+        }
+        close(hold_fd);
+    });
+
+    ReferenceStream stream(ref_tensor, tol);
+    TextTensorStream parser(fifo_path);
+    CooBuffer chunk;
+    TensorMismatch mismatch;
+    bool match = true, stopped = false;
+    std::exception_ptr error;
+    try {
+        char buf[1 << 16];
+        while (true) {
+            ssize_t n = read(read_fd, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) throw std::runtime_error("Cannot read FIFO " + fifo_path + ": " + strerror(errno));
+            chunk.clear();
+            if (n == 0) {
+                parser.finish(chunk);
+                match = stream.add(chunk, &mismatch) && stream.finish(&mismatch);
+                break;
+            }
+            parser.feed(buf, n, chunk);
+            if (!stream.add(chunk, &mismatch)) {
+                match = false;
+                stopped = true;
+                break;
+            }
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    // A kernel still writing gets EPIPE/SIGPIPE from here on
+    close(read_fd);
+    kernel.join();
+    fs::remove(fifo_path);
+    if (error) std::rethrow_exception(error);
+
+    if (!match && (stopped || status == 0)) {
+        LOG_INFO("Output mismatch at " + mismatch.to_string() + " (" + fifo_path + (stopped ? ", kernel stopped)" : ")"));
+    }
+    if (stopped) {
+        equal = false;
+        return 0;
+    }
+    equal = match;
+    return status;
 }
 
-}
\ No newline at end of file
+}
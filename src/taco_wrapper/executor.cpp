@@ -2,46 +2,145 @@
 
 namespace taco_wrapper {
 
-int run_kernel(const string& kernelPath, const string& exe_file_name, const string& tool_path)
+string KernelBuildConfig::flags() const
+{
+    // The precompiled harness is picked up in place of the header as long as these flags
+    // match the ones it was built with (-std and the absence of -O/-D)
+    string flags = "-std=c++17";
+    if (!harness_pch_dir.empty())
+        flags += " -I" + harness_pch_dir;
+    if (!harness_include.empty())
+        flags += " -I" + harness_include;
+    flags += " -I" + (tool_path + "/include");
+    return flags;
+}
+
+string KernelBuildConfig::fingerprint() const
+{
+    namespace fs = std::filesystem;
+    string id = compiler + " " + flags();
+    vector<string> inputs = {harness_lib, tool_path + "/build/lib/libtaco.so", tool_path + "/build/lib/libtaco.dylib"};
+    if (!harness_include.empty()) inputs.push_back(harness_include + "/taco_wrapper/taco_harness.hpp");
+    if (!harness_pch_dir.empty()) inputs.push_back(harness_pch_dir + "/taco_wrapper/taco_harness.hpp.gch");
+    for (auto& input : inputs) {
+        error_code ec;
+        if (input.empty() || !fs::exists(input, ec)) continue;
+        auto size = fs::file_size(input, ec);
+        auto mtime = fs::last_write_time(input, ec).time_since_epoch().count();
+        id += " " + input + ":" + to_string(size) + ":" + to_string(mtime);
+    }
+    return id;
+}
+
+KernelBuildConfig default_build_config(const string& tool_path)
+{
+    KernelBuildConfig config;
+    config.tool_path = tool_path;
+#ifdef TACO_KERNEL_CXX
+    config.compiler = TACO_KERNEL_CXX;
+#endif
+#ifdef TACO_HARNESS_INCLUDE_DIR
+    config.harness_include = TACO_HARNESS_INCLUDE_DIR;
+#endif
+#ifdef TACO_HARNESS_PCH_DIR
+    config.harness_pch_dir = TACO_HARNESS_PCH_DIR;
+#endif
+#ifdef TACO_HARNESS_LIB
+    config.harness_lib = TACO_HARNESS_LIB;
+#endif
+    return config;
+}
+
+int compile_kernel(const string& kernelPath, const string& exe_file_name, const KernelBuildConfig& config, uint64_t timeout_ms)
 {
     namespace fs = std::filesystem;
 
     if (!fs::exists(kernelPath))
     {
         cerr << "Kernel file not found: " << kernelPath << "\n";
-        return false;
+        return 1;
     }
 
-    // 1. Build the executable kernel
-    string compileCmd = "g++ " + kernelPath + " -std=c++17"
-                            " -I" + (tool_path + "/include") +
-                            " -L" + (tool_path + "/build/lib") +
+    // Build the executable kernel (the harness library references TACO, so it goes first)
+    string compileCmd = config.compiler + " " + kernelPath + " " + config.flags() +
+                            (config.harness_lib.empty() ? "" : " " + config.harness_lib) +
+                            " -L" + (config.tool_path + "/build/lib") +
                             " -ltaco" +
-                            " -Wl,-rpath," + (tool_path + "/build/lib") +
+                            " -Wl,-rpath," + (config.tool_path + "/build/lib") +
                             " -o " + exe_file_name;
     
     std::cout << "[INFO] Compiling kernel: " << compileCmd << std::endl;
 
-    int ret = std::system(compileCmd.c_str());
-    if (ret != 0)
+    ProcessResult result = run_shell(compileCmd, timeout_ms);
+    if (result.status() != 0)
     {
-        std::cerr << "Compilation failed for " << kernelPath << std::endl;
-        return WEXITSTATUS(ret);
+        std::cerr << "Compilation failed for " << kernelPath << ": " << result.summary() << std::endl;
+        return result.status();
     }
+    return 0;
+}
 
-    // 2. Run the executable
-    ret = std::system(exe_file_name.c_str());
-    if (ret == -1)
+// Log the outcome of a kernel process and map it to the backend status convention
+static int report(const string& what, const ProcessResult& result)
+{
+    if (!result.spawned)
     {
-        std::cerr << "Failed to start process (system() error)\n";
-    } else if (WIFEXITED(ret) && WEXITSTATUS(ret) == 0) {
-        std::cout << "Kernel Execution Succeeded!\n";
-        return 0;
+        std::cerr << "Failed to start " << what << "\n";
+    } else if (result.timed_out) {
+        std::cerr << what << " " << result.summary() << "\n";
+    } else if (result.signal != 0) {
+        std::cerr << what << " terminated by signal: " << result.signal << " (" << result.summary() << ")\n";
+    } else if (result.exit_code == 0) {
+        std::cout << what << " Succeeded!\n";
     } else {
-        std::cerr << "Kernel Execution failed with code: " << WEXITSTATUS(ret) << "\n";
+        std::cerr << what << " failed with code: " << result.exit_code << "\n";
     }
+    return result.status();
+}
 
-    return WEXITSTATUS(ret);
+int run_executable(const string& exe_file_name, const vector<string>& args, uint64_t timeout_ms)
+{
+    vector<string> argv = {exe_file_name};
+    argv.insert(argv.end(), args.begin(), args.end());
+    // The kernel applies the memory budget to itself once TACO has compiled it
+    int status = kernel_status(report("Kernel Execution", run_process(argv, timeout_ms)));
+    if (status == PROCESS_OUT_OF_MEMORY) std::cerr << "Kernel Execution ran out of its memory budget\n";
+    return status;
 }
 
-}
\ No newline at end of file
+int run_kernel(const string& kernelPath, const string& exe_file_name, const KernelBuildConfig& config, const vector<string>& args, uint64_t timeout_ms)
+{
+    int ret = compile_kernel(kernelPath, exe_file_name, config, timeout_ms);
+    if (ret != 0)
+        return ret;
+
+    return run_executable(exe_file_name, args, timeout_ms);
+}
+
+int run_taco_runner(const string& runner_path, const string& kernel_json, const vector<string>& results_files, uint64_t timeout_ms)
+{
+    namespace fs = std::filesystem;
+
+    if (!fs::exists(kernel_json))
+    {
+        cerr << "Kernel specification not found: " << kernel_json << "\n";
+        return 1;
+    }
+
+    vector<string> args = {kernel_json};
+    args.insert(args.end(), results_files.begin(), results_files.end());
+    return run_executable(runner_path, args, timeout_ms);
+}
+
+int run_taco_runner_batch(const string& runner_path, const string& manifest_file, const string& status_file, uint64_t timeout_ms,
+                          uint64_t kernel_timeout_ms)
+{
+    ProcessResult result = run_process({runner_path, "--batch", manifest_file, status_file, to_string(kernel_timeout_ms)}, timeout_ms);
+    if (result.status() != 0)
+    {
+        std::cerr << "Batch runner " << result.summary() << "\n";
+    }
+    return result.status();
+}
+
+}
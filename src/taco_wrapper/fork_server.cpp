@@ -0,0 +1,191 @@
+#include "taco_wrapper/fork_server.hpp"
+#include "tensure/process.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace taco_wrapper {
+
+static bool read_all(int fd, void* buf, size_t len)
+{
+    char* p = static_cast<char*>(buf);
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// send() instead of write() so a dead server surfaces as an error rather than SIGPIPE
+static bool send_all(int fd, const void* buf, size_t len)
+{
+    const char* p = static_cast<const char*>(buf);
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+ForkServer::ForkServer(const string& runner_path) : runner_path(runner_path) {}
+
+ForkServer::~ForkServer()
+{
+    stop();
+}
+
+bool ForkServer::start()
+{
+    int ctl[2], st[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, ctl) != 0)
+        return false;
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, st) != 0) {
+        close(ctl[0]);
+        close(ctl[1]);
+        return false;
+    }
+
+    // Build argv before forking: only async-signal-safe calls are allowed in the child
+    string arg0 = runner_path;
+    string arg1 = "--fork-server";
+    char* argv[] = {arg0.data(), arg1.data(), nullptr};
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Keep terminal signals aimed at the fuzzer away from the server;
+        // dup2 clears close-on-exec on the server's ends
+        setpgid(0, 0);
+        if (dup2(ctl[1], FORKSRV_FD) < 0 || dup2(st[1], FORKSRV_FD + 1) < 0)
+            _exit(127);
+        execv(argv[0], argv);
+        _exit(127);
+    }
+
+    close(ctl[1]);
+    close(st[1]);
+    if (pid < 0) {
+        close(ctl[0]);
+        close(st[0]);
+        cerr << "Failed to fork the TACO fork server\n";
+        return false;
+    }
+
+    server_pid = pid;
+    ctl_fd = ctl[0];
+    st_fd = st[0];
+
+    uint32_t hello = 0;
+    if (!read_all(st_fd, &hello, sizeof(hello))) {
+        cerr << "TACO fork server failed to start: " << runner_path << "\n";
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void ForkServer::stop()
+{
+    if (ctl_fd >= 0) close(ctl_fd);
+    if (st_fd >= 0) close(st_fd);
+    ctl_fd = st_fd = -1;
+
+    if (server_pid > 0) {
+        // Don't wait for the server to see EOF: it may be blocked on a hung child
+        kill(server_pid, SIGKILL);
+        while (waitpid(server_pid, nullptr, 0) < 0 && errno == EINTR) {}
+    }
+    server_pid = -1;
+}
+
+// Wait until fd is readable or the deadline passes
+static bool wait_readable(int fd, chrono::steady_clock::time_point deadline)
+{
+    using namespace std::chrono;
+    while (true) {
+        auto remaining = duration_cast<milliseconds>(deadline - steady_clock::now()).count();
+        if (remaining <= 0) return false;
+        pollfd pfd{fd, POLLIN, 0};
+        int ret = poll(&pfd, 1, static_cast<int>(min<long long>(remaining, INT32_MAX)));
+        if (ret > 0) return true;
+        if (ret < 0 && errno != EINTR) return false;
+    }
+}
+
+int ForkServer::run(const string& kernel_json, const vector<string>& results_files, uint64_t timeout_ms)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+
+    if (server_pid < 0 && !start())
+        return -1;
+
+    string request = kernel_json;
+    for (auto& results_file : results_files) {
+        request += " " + results_file;
+    }
+
+    uint32_t len = request.size();
+    if (!send_all(ctl_fd, &len, sizeof(len)) || !send_all(ctl_fd, request.data(), len)) {
+        stop();
+        return -1;
+    }
+
+    int32_t child_pid = -1, status = 0;
+    if (!read_all(st_fd, &child_pid, sizeof(child_pid))) {
+        cerr << "TACO fork server died before running " << kernel_json << "\n";
+        stop();
+        return -1;
+    }
+    if (child_pid <= 0) {
+        // The server follows a failed fork with a status word too; drain it so the next
+        // request does not read it as its pid
+        if (!read_all(st_fd, &status, sizeof(status))) stop();
+        cerr << "TACO fork server could not fork for " << kernel_json << "\n";
+        return -1;
+    }
+
+    bool timed_out = false;
+    if (timeout_ms > 0 && !wait_readable(st_fd, deadline)) {
+        // The server reaps the killed child and still reports its status below.
+        // child_pid > 0 here, so this never signals the fuzzer's own group.
+        if (kill(-child_pid, SIGKILL) != 0) kill(child_pid, SIGKILL);
+        timed_out = true;
+    }
+    if (!read_all(st_fd, &status, sizeof(status))) {
+        cerr << "TACO fork server died while running " << kernel_json << "\n";
+        stop();
+        return -1;
+    }
+
+    if (timed_out) {
+        cerr << "Kernel Execution killed after " << timeout_ms << " ms\n";
+        return PROCESS_TIMEOUT;
+    }
+
+    if (WIFSIGNALED(status)) {
+        cerr << "Kernel Execution terminated by signal: " << WTERMSIG(status) << "\n";
+        return 128 + WTERMSIG(status);
+    }
+    if (kernel_status(WEXITSTATUS(status)) == PROCESS_OUT_OF_MEMORY) {
+        cerr << "Kernel Execution ran out of its memory budget\n";
+        return PROCESS_OUT_OF_MEMORY;
+    }
+    if (WEXITSTATUS(status) != 0) {
+        cerr << "Kernel Execution failed with code: " << WEXITSTATUS(status) << "\n";
+    }
+    return WEXITSTATUS(status);
+}
+
+}
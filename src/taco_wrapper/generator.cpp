@@ -1,24 +1,57 @@
 #include "taco_wrapper/generator.hpp"
+#include "taco_wrapper/taco_harness.hpp"
 
 namespace taco_wrapper {
 
-TacoTensor toTacoTensor(const tsTensor& t, const string& dataFilename)
+TacoTensor toTacoTensor(const tsTensor& t, int dataArgIndex)
 {
     TacoTensor tacoT;
     tacoT.name = std::string(1, t.name);
     tacoT.shape = t.shape;
     tacoT.idxs = t.idxs;
     tacoT.fmt = t.storageFormat;
-    tacoT.dataFilename = dataFilename;
+    tacoT.dataArgIndex = dataArgIndex;
 
     return tacoT;
 }
 
-bool generate_taco_kernel(const tsKernel& kernel, const fs::path& out_file, std::vector<fs::path> results_file) {
+static bool has_data_file(const tsKernel& kernel, const tsTensor& t)
+{
+    auto it = kernel.dataFileNames.find(std::string(1, t.name));
+    return it != kernel.dataFileNames.end() && it->second != "-";
+}
+
+string kernel_dims(const tsKernel& kernel)
+{
+    map<char, int> dims;
+    for (auto &tensor : kernel.tensors)
+    {
+        for (size_t m = 0; m < tensor.idxs.size() && m < tensor.shape.size(); m++)
+            dims[tensor.idxs[m]] = tensor.shape[m];
+    }
+
+    vector<string> items;
+    for (auto &[idx, dim] : dims)
+        items.push_back(string(1, idx) + "=" + to_string(dim));
+    return join(items, ",");
+}
+
+vector<string> kernel_data_files(const tsKernel& kernel)
+{
+    vector<string> data_files;
+    for (auto &tensor : kernel.tensors)
+    {
+        if (has_data_file(kernel, tensor))
+            data_files.push_back(kernel.dataFileNames.at(std::string(1, tensor.name)));
+    }
+    return data_files;
+}
+
+bool generate_taco_kernel(const tsKernel& kernel, const fs::path& out_file) {
     try {
         // generate TACO program string
         fs::create_directories(out_file);
-        string program_code = generate_program(kernel, results_file);
+        string program_code = generate_program(kernel);
 
         // atomic write
         string tmp_name = out_file / ((out_file.parent_path().stem().string()) + ".tmp");
@@ -34,7 +67,7 @@ bool generate_taco_kernel(const tsKernel& kernel, const fs::path& out_file, std:
     return true;
 }
 
-string generate_program(const tsKernel &kernel_info, std::vector<fs::path> results_file)
+string generate_program(const tsKernel &kernel_info)
 {
     int tab_space_count = 4;
     std::string space = "";
@@ -43,21 +76,30 @@ string generate_program(const tsKernel &kernel_info, std::vector<fs::path> resul
             space += " ";
     }
     ostringstream oss;
-    oss << "#include <iostream>\n#include <fstream>\n#include <sstream>\n#include <vector>\n#include <string>\n#include <stdexcept>\n#include \"taco.h\"\n\nusing namespace taco;\n\nint read_taco_file(std::string file_name, Tensor<double>& T)\n{\n\tstd::ifstream file(file_name);\n\tif (!file.is_open()) {\n\t\tthrow std::runtime_error(\"Failed to open file: \" + file_name);\n\t}\n\n\t std::string line;\n\twhile (std::getline(file, line)) {\n\t\tif (line.empty() || line[0] == '#') continue;\n\n\t\tstd::istringstream iss(line);\n\t\tstd::vector<double> tokens;\n\t\tdouble tmp;\n\n\twhile (iss >> tmp) {\n\t\t\ttokens.push_back(tmp);\n\t\t}\n\n\t\tif (tokens.size() < 2) {\n\t\t\tthrow std::runtime_error(\"Malformed line: \" + line);\n\t\t}\n\n\t\tstd::vector<int> coord;\n\t\tcoord.reserve(tokens.size() - 1);\n\n\t\tfor (size_t i =0; i < tokens.size() -  1; i++) {\n\t\t\tcoord.push_back(static_cast<int>(tokens[i]));\n\t\t}\n\t\tT.insert(coord, tokens.back());\n\t}\n\treturn 0;\n}\n\nint main() {\n";
+    // File loading, result writing and argument checking live in the prebuilt harness (taco_harness.hpp)
+    oss << "#include \"taco_wrapper/taco_harness.hpp\"\n\nusing namespace taco;\nusing namespace taco_harness;\n\nint main(int argc, char* argv[]) {\n";
     
     set<char> indexVar;
     vector<string> tensor_init = {};
+    vector<string> data_args = {};
     for(size_t i = 0; i < kernel_info.tensors.size(); i++)
     {
         const tsTensor &tensor = kernel_info.tensors[i];
-        string tensorDataFilename = kernel_info.dataFileNames.at(std::string(1, tensor.name));
+        int dataArgIndex = -1;
+        if (has_data_file(kernel_info, tensor))
+        {
+            data_args.push_back(std::string(1, tensor.name));
+            dataArgIndex = taco_harness::FIRST_DATA_ARG + data_args.size() - 1;
+        }
         for (auto &id : tensor.idxs)
             indexVar.insert(id);
-        TacoTensor tacoTensor = toTacoTensor(tensor, tensorDataFilename);
+        TacoTensor tacoTensor = toTacoTensor(tensor, dataArgIndex);
         tensor_init.push_back(tacoTensor.initilization_string(space));
         // std::cout << tacoTensor.initilization_string(4) << std::endl;
     }
-    oss << space << "IndexVar " << join(indexVar) << ";\n\n";
+    oss << space << "check_args(argc, argv, " << data_args.size() << ", \"" << join(data_args, " ") << "\");\n\n";
+    oss << space << "IndexVar " << join(indexVar) << ";\n";
+    oss << space << "std::map<char, int> dims = read_dims(argv[DIMS_ARG], \"" << string(indexVar.begin(), indexVar.end()) << "\");\n\n";
 
     for (auto &tensor_vals : tensor_init)
     {
@@ -70,13 +112,11 @@ string generate_program(const tsKernel &kernel_info, std::vector<fs::path> resul
     }
 
     oss << space << kernel_info.tensors[0].name << ".compile();\n";
+    oss << space << "limit_memory();\n";
     oss << space << kernel_info.tensors[0].name << ".assemble();\n";
     oss << space << kernel_info.tensors[0].name << ".compute();\n\n";
 
-    for (auto &results_file_path : results_file) {
-        fs::path abs_results_file_path = std::filesystem::absolute(std::filesystem::current_path() / results_file_path);
-        oss << space << "write(\"" << abs_results_file_path.string() << "\", " << kernel_info.tensors[0].name << ");\n";
-    }
+    oss << space << "write_results(argc, argv, " << data_args.size() << ", " << kernel_info.tensors[0].name << ");\n";
     oss << "\n" << space << "return 0;\n";
 
     oss << "}";
@@ -0,0 +1,172 @@
+#include "taco_wrapper/kernel_cache.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace taco_wrapper {
+
+static string read_file(const fs::path& path)
+{
+    ifstream in(path, ios::binary);
+    ostringstream oss;
+    oss << in.rdbuf();
+    return oss.str();
+}
+
+// Link (or copy, across filesystems) src to dst, replacing dst
+static void place_file(const fs::path& src, const fs::path& dst)
+{
+    error_code ec;
+    fs::remove(dst, ec);
+    fs::create_hard_link(src, dst, ec);
+    if (ec) {
+        fs::copy_file(src, dst, fs::copy_options::overwrite_existing);
+    }
+}
+
+// Unique temporary name next to path, so concurrent writers never clash
+static fs::path temp_name(const fs::path& path)
+{
+    ostringstream oss;
+    oss << path.string() << ".tmp." << std::this_thread::get_id();
+    return oss.str();
+}
+
+KernelCache::KernelCache(const fs::path& dir, uintmax_t max_bytes, size_t max_entries)
+    : dir_(dir), max_bytes_(max_bytes), max_entries_(max_entries)
+{
+    fs::create_directories(dir_);
+
+    // Rebuild the index from a previous run
+    for (auto& entry : fs::directory_iterator(dir_)) {
+        fs::path p = entry.path();
+        if (p.string().find(".tmp.") != string::npos) {
+            error_code ec;
+            fs::remove(p, ec);
+            continue;
+        }
+        if (p.extension() != ".out") continue;
+
+        fs::path src = p;
+        src.replace_extension(".cpp");
+        if (!fs::exists(src)) {
+            fs::remove(p);
+            continue;
+        }
+
+        Entry e;
+        e.bytes = fs::file_size(p) + fs::file_size(src);
+        e.last_used = fs::last_write_time(p);
+        index_[p.stem().string()] = e;
+        total_bytes_ += e.bytes;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    evict_locked();
+}
+
+string KernelCache::key_of(const string& source, const string& build_config)
+{
+    // 64-bit FNV-1a; collisions are caught by comparing the stored source on fetch()
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const string& s) {
+        for (unsigned char c : s) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+    };
+    mix(build_config);
+    mix("\n");
+    mix(source);
+
+    ostringstream oss;
+    oss << hex << setw(16) << setfill('0') << h;
+    return oss.str();
+}
+
+bool KernelCache::fetch(const string& key, const string& source, const fs::path& exe_path)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = index_.find(key);
+    if (it == index_.end() || read_file(dir_ / (key + ".cpp")) != source) {
+        misses_++;
+        return false;
+    }
+
+    try {
+        fs::path cached = dir_ / (key + ".out");
+        place_file(cached, exe_path);
+        it->second.last_used = fs::file_time_type::clock::now();
+        fs::last_write_time(cached, it->second.last_used);
+    } catch (const exception& e) {
+        cerr << "KernelCache::fetch failed: " << e.what() << endl;
+        misses_++;
+        return false;
+    }
+
+    hits_++;
+    return true;
+}
+
+void KernelCache::store(const string& key, const string& source, const fs::path& exe_path)
+{
+    fs::path cached = dir_ / (key + ".out");
+    fs::path cached_src = dir_ / (key + ".cpp");
+
+    try {
+        // Publish atomically: the source first, then the executable that marks the entry valid
+        fs::path tmp_src = temp_name(cached_src);
+        {
+            ofstream out(tmp_src, ios::binary);
+            out << source;
+        }
+        fs::rename(tmp_src, cached_src);
+
+        fs::path tmp_exe = temp_name(cached);
+        place_file(exe_path, tmp_exe);
+        fs::rename(tmp_exe, cached);
+
+        std::lock_guard<std::mutex> lock(mtx_);
+        Entry e;
+        e.bytes = fs::file_size(cached) + fs::file_size(cached_src);
+        e.last_used = fs::last_write_time(cached);
+
+        auto it = index_.find(key);
+        if (it != index_.end()) total_bytes_ -= it->second.bytes;
+        index_[key] = e;
+        total_bytes_ += e.bytes;
+        evict_locked();
+    } catch (const exception& e) {
+        cerr << "KernelCache::store failed: " << e.what() << endl;
+    }
+}
+
+void KernelCache::evict_locked()
+{
+    while (!index_.empty() && (total_bytes_ > max_bytes_ || index_.size() > max_entries_)) {
+        auto oldest = index_.begin();
+        for (auto it = index_.begin(); it != index_.end(); ++it) {
+            if (it->second.last_used < oldest->second.last_used) oldest = it;
+        }
+
+        error_code ec;
+        fs::remove(dir_ / (oldest->first + ".out"), ec);
+        fs::remove(dir_ / (oldest->first + ".cpp"), ec);
+        total_bytes_ -= oldest->second.bytes;
+        index_.erase(oldest);
+    }
+}
+
+string KernelCache::stats()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    ostringstream oss;
+    oss << "Kernel cache: " << hits_.load() << " hits / " << misses_.load() << " misses, "
+        << index_.size() << " entries, " << (total_bytes_ >> 20) << " MB";
+    return oss.str();
+}
+
+}
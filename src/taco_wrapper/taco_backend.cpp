@@ -1,4 +1,44 @@
 #include "taco_wrapper/taco_backend.hpp"
+#include "tensure/tensor_io.hpp"
+
+TacoBackend::TacoBackend() {
+    // The runner location is baked in at build time and can be overridden with TACO_RUNNER
+#ifdef TACO_RUNNER_PATH
+    runner_path = TACO_RUNNER_PATH;
+#endif
+    if (const char* env = getenv("TACO_RUNNER")) runner_path = env;
+
+    string mode_name = "runner";
+    if (const char* env = getenv("TENSURE_TACO_MODE")) mode_name = env;
+
+    if (mode_name == "compile") {
+        mode = TacoExecMode::Compile;
+    } else if (mode_name != "runner") {
+        cerr << "Unknown TENSURE_TACO_MODE: " << mode_name << ", using runner\n";
+    }
+
+    if (const char* env = getenv("TACO_FORKSERVER")) use_fork_server = string(env) != "0";
+    if (const char* env = getenv("TACO_FINGERPRINT")) fingerprint_mutants = string(env) != "0";
+
+    if (mode == TacoExecMode::Runner && (runner_path.empty() || !fs::exists(runner_path))) {
+        cerr << "taco_runner not found at '" << runner_path.string() << "', falling back to compiling kernels\n";
+        mode = TacoExecMode::Compile;
+    }
+
+    // Compiled kernels are cached across iterations and runs, bounded by size and entry count
+    if (mode == TacoExecMode::Compile) {
+        fs::path cache_dir = "fuzz_output/kernel_cache";
+        uintmax_t cache_mb = 2048;
+        size_t cache_entries = 10000;
+        if (const char* env = getenv("TACO_KERNEL_CACHE")) cache_dir = env;
+        if (const char* env = getenv("TACO_KERNEL_CACHE_MB")) cache_mb = stoull(env);
+        if (const char* env = getenv("TACO_KERNEL_CACHE_ENTRIES")) cache_entries = stoull(env);
+
+        if (cache_mb > 0 && cache_entries > 0) {
+            kernel_cache = make_unique<taco_wrapper::KernelCache>(cache_dir, cache_mb << 20, cache_entries);
+        }
+    }
+}
 
 bool TacoBackend::generate_kernel(const vector<string>& mutated_kernel_file_names, const fs::path& output_dir) {
     // Call your existing executor.cpp function
@@ -9,36 +49,230 @@ bool TacoBackend::generate_kernel(const vector<string>& mutated_kernel_file_name
         fs::create_directories(taco_kernel_file);
         tsKernel tskernel;
         tskernel.loadJson(mutated_file_name);
-        if (i==0)
-        {
-            taco_wrapper::generate_taco_kernel(tskernel, taco_kernel_file, {(taco_kernel_file / "results.tns"), (p.parent_path() / "data" / "ref_out" / "results.tns")});
-        } else {
-
-            taco_wrapper::generate_taco_kernel(tskernel, taco_kernel_file, {(taco_kernel_file / "results.tns")});
-        }
-        fs::remove(p);
+        taco_wrapper::generate_taco_kernel(tskernel, taco_kernel_file);
+        // Keep the specification next to the generated program: execution reads its tensors and data files
+        fs::rename(p, taco_kernel_file / "kernel.json");
     }
     
     return true;
 }
 
 int TacoBackend::execute_kernel(const fs::path& kernelPath, const fs::path& outputDir) {
-    // Call your existing executor.cpp function
-    std::filesystem::path taco_path = std::filesystem::absolute(std::filesystem::current_path() / "../external/taco");
+    return execute_kernel(kernelPath, outputDir, 0);
+}
+
+int TacoBackend::execute_kernel(const fs::path& kernelPath, const fs::path& outputDir, uint64_t timeout_ms) {
     std::filesystem::path abs_srcPath = std::filesystem::absolute(std::filesystem::current_path() / kernelPath);
     std::filesystem::path abs_outPath = std::filesystem::absolute(std::filesystem::current_path() / kernelPath.parent_path());
+    return run_kernel(abs_srcPath, abs_outPath, results_files(abs_outPath), timeout_ms);
+}
+
+int TacoBackend::run_kernel(const fs::path& abs_srcPath, const fs::path& abs_outPath, const vector<string>& results, uint64_t timeout_ms) {
+    if (mode == TacoExecMode::Runner) {
+        string kernel_json = (abs_outPath / "kernel.json").string();
+        if (use_fork_server) {
+            int ret = fork_server().run(kernel_json, results, timeout_ms);
+            if (ret != -1)
+                return ret;
+        }
+        return taco_wrapper::run_taco_runner(runner_path.string(), kernel_json, results, timeout_ms);
+    }
 
     std::filesystem::path exe_path = abs_outPath / abs_srcPath.stem();
     exe_path.replace_extension(".out");
-    
-    int ret = taco_wrapper::run_kernel(abs_srcPath.string(), exe_path.string(), taco_path.string());
 
+    // Generated programs take their index extents, data and result files as arguments
+    tsKernel tskernel;
+    tskernel.loadJson((abs_outPath / "kernel.json").string());
+    vector<string> args = {taco_wrapper::kernel_dims(tskernel)};
+    for (auto &data_file : taco_wrapper::kernel_data_files(tskernel)) {
+        args.push_back(fs::absolute(data_file).string());
+    }
+    for (auto &results_file : results) {
+        args.push_back(results_file);
+    }
+
+    // Built already if compile_kernel() ran ahead of execution
+    if (!fs::exists(exe_path)) {
+        int ret = build_executable(abs_srcPath, exe_path, timeout_ms);
+        if (ret != 0)
+            return ret;
+    }
+
+    return taco_wrapper::run_executable(exe_path.string(), args, timeout_ms);
+}
+
+int TacoBackend::compile_kernel(const fs::path& kernelPath, uint64_t timeout_ms) {
+    // The runner builds kernels through TACO's API at execution time
+    if (mode == TacoExecMode::Runner)
+        return 0;
+
+    std::filesystem::path abs_srcPath = std::filesystem::absolute(std::filesystem::current_path() / kernelPath);
+    std::filesystem::path exe_path = abs_srcPath.parent_path() / abs_srcPath.stem();
+    exe_path.replace_extension(".out");
+    return build_executable(abs_srcPath, exe_path, timeout_ms);
+}
+
+int TacoBackend::build_executable(const fs::path& abs_srcPath, const fs::path& exe_path, uint64_t timeout_ms) {
+    // Call your existing executor.cpp function
+    std::filesystem::path taco_path = std::filesystem::absolute(std::filesystem::current_path() / "../external/taco");
+    taco_wrapper::KernelBuildConfig build_config = taco_wrapper::default_build_config(taco_path.string());
+
+    if (!kernel_cache) {
+        return taco_wrapper::compile_kernel(abs_srcPath.string(), exe_path.string(), build_config, timeout_ms);
+    }
+
+    ifstream src_in(abs_srcPath);
+    string source((istreambuf_iterator<char>(src_in)), istreambuf_iterator<char>());
+    string key = taco_wrapper::KernelCache::key_of(source, build_config.fingerprint());
+
+    if (!kernel_cache->fetch(key, source, exe_path)) {
+        int ret = taco_wrapper::compile_kernel(abs_srcPath.string(), exe_path.string(), build_config, timeout_ms);
+        if (ret != 0)
+            return ret;
+        kernel_cache->store(key, source, exe_path);
+    }
+    return 0;
+}
+
+vector<int> TacoBackend::execute_kernels(const vector<fs::path>& kernelPaths, const fs::path& outputDir) {
+    return execute_kernels(kernelPaths, outputDir, 0);
+}
+
+vector<int> TacoBackend::execute_kernels(const vector<fs::path>& kernelPaths, const fs::path& outputDir, uint64_t timeout_ms) {
+    if (mode != TacoExecMode::Runner || kernelPaths.empty()) {
+        return FuzzBackend::execute_kernels(kernelPaths, outputDir, timeout_ms);
+    }
+
+    // The manifest and statuses live next to the kernel directories (backend_kernel/)
+    fs::path batch_dir = fs::absolute(fs::current_path() / kernelPaths[0].parent_path().parent_path());
+    fs::path manifest_file = batch_dir / "batch_manifest.txt";
+    fs::path status_file = batch_dir / "batch_status.txt";
+    {
+        ofstream manifest(manifest_file);
+        for (auto& kernelPath : kernelPaths) {
+            fs::path kernel_dir = fs::absolute(fs::current_path() / kernelPath.parent_path());
+            manifest << (kernel_dir / "kernel.json").string();
+            for (auto& results_file : results_files(kernel_dir)) {
+                manifest << " " << results_file;
+            }
+            manifest << "\n";
+        }
+    }
+    fs::remove(status_file);
+
+    // Each kernel is killed at its own deadline inside the batch. The batch as a whole gets one
+    // more for parsing the inputs; kernels it did not get to are executed (and timed) individually.
+    int ret = taco_wrapper::run_taco_runner_batch(runner_path.string(), manifest_file.string(), status_file.string(),
+                                                  timeout_ms * (kernelPaths.size() + 1), timeout_ms);
+    if (ret != 0) {
+        cerr << "Batch runner failed with code " << ret << ", executing the remaining kernels one by one\n";
+    }
+
+    map<size_t, int> statuses;
+    ifstream status_in(status_file);
+    size_t idx;
+    int status;
+    while (status_in >> idx >> status) {
+        statuses[idx] = status;
+    }
+
+    vector<int> results;
+    for (size_t i = 0; i < kernelPaths.size(); i++) {
+        auto it = statuses.find(i);
+        results.push_back(it != statuses.end() ? it->second : execute_kernel(kernelPaths[i], outputDir, timeout_ms));
+    }
+    return results;
+}
+
+bool TacoBackend::rebind_kernel(const fs::path& kernelPath, const tsKernel& kernel) {
+    fs::path kernel_json = fs::absolute(fs::current_path() / kernelPath).parent_path() / "kernel.json";
+    if (!fs::exists(kernel_json)) return false;
+
+    // Stale outputs of the previous inputs must not be mistaken for new ones
+    for (const char* name : {"results.tns", "results.bin"}) {
+        fs::path results_file = kernel_json.parent_path() / name;
+        error_code ec;
+        fs::remove(results_file, ec);
+        fs::remove(fingerprint_file_of(results_file.string()), ec);
+    }
+
+    tsKernel rebound = kernel;
+    rebound.saveJson(kernel_json.string());
+    return true;
+}
+
+int TacoBackend::execute_and_compare(const fs::path& kernelPath, const fs::path& outputDir, uint64_t timeout_ms,
+                                     ComparisonSession& session, const string& testDir, bool& equal) {
+    std::filesystem::path abs_srcPath = std::filesystem::absolute(std::filesystem::current_path() / kernelPath);
+    std::filesystem::path abs_outPath = abs_srcPath.parent_path();
+
+    // Only text results are parsed as they arrive
+    auto* ref_comparison = dynamic_cast<taco_wrapper::ReferenceComparison*>(&session);
+    if (!ref_comparison || results_name(abs_outPath) != "results.tns" || !ref_comparison->supports_streaming()) {
+        return FuzzBackend::execute_and_compare(kernelPath, outputDir, timeout_ms, session, testDir, equal);
+    }
+
+    string results_file = (abs_outPath / "results.tns").string();
+    auto run = [&](const string& file) { return run_kernel(abs_srcPath, abs_outPath, {file}, timeout_ms); };
+    int ret = ref_comparison->compare_streamed(results_file, run, equal);
+
+    // The stream is gone; a wrong output is written again for the failure archive
+    if (ret == 0 && !equal && run(results_file) != 0) {
+        cerr << "Failed to write the results of " << kernelPath << "\n";
+    }
     return ret;
 }
 
+taco_wrapper::ForkServer& TacoBackend::fork_server() {
+    // Each worker thread gets its own server (started lazily on first use), so requests never interleave
+    lock_guard<mutex> lock(fork_servers_mtx);
+    auto& server = fork_servers[this_thread::get_id()];
+    if (!server) {
+        server = make_unique<taco_wrapper::ForkServer>(runner_path.string());
+    }
+    return *server;
+}
+
+string TacoBackend::results_name(const fs::path& kernel_dir) const {
+    // Results are written in the binary format when the inputs are
+    tsKernel kernel;
+    kernel.loadJson((kernel_dir / "kernel.json").string());
+    for (auto& [name, data_file] : kernel.dataFileNames) {
+        if (is_bin_tensor_file(data_file)) return "results.bin";
+    }
+    return "results.tns";
+}
+
+vector<string> TacoBackend::results_files(const fs::path& kernel_dir) const {
+    string results_name = this->results_name(kernel_dir);
+
+    // The reference kernel ("kernel") also publishes its result to iter_dir/data/ref_out
+    vector<string> results_files = {(kernel_dir / results_name).string()};
+    if (kernel_dir.stem() == "kernel") {
+        results_files.push_back((kernel_dir.parent_path().parent_path() / "data" / "ref_out" / results_name).string());
+    } else if (fingerprint_mutants) {
+        // Mutants are compared by fingerprint; large outputs are written in full only on a mismatch
+        results_files[0] = fingerprint_file_of(results_files[0]);
+    }
+    return results_files;
+}
+
+string TacoBackend::stats() {
+    return kernel_cache ? kernel_cache->stats() : "";
+}
+
 bool TacoBackend::compare_results(const string& refDir, const string& testDir) {
-    // Call your existing comparator.cpp function
-    return taco_wrapper::compare_outputs(refDir, testDir);
+    return taco_wrapper::compare_outputs(taco_wrapper::resolve_results_file(refDir), taco_wrapper::resolve_results_file(testDir));
+}
+
+unique_ptr<ComparisonSession> TacoBackend::open_comparison(const string& refDir, uint64_t timeout_ms) {
+    // Mutants that only wrote a fingerprint run again, within timeout_ms, to write their results in full
+    auto write_full_results = [this, timeout_ms](const string& results_file) {
+        fs::path kernel_dir = fs::absolute(results_file).parent_path();
+        return run_kernel(kernel_dir / "backend_kernel.cpp", kernel_dir, {fs::absolute(results_file).string()}, timeout_ms) == 0;
+    };
+    return make_unique<taco_wrapper::ReferenceComparison>(refDir, 1e-8, write_full_results);
 }
 
 // Plugin entry points
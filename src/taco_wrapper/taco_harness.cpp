@@ -0,0 +1,147 @@
+#include "taco_wrapper/taco_harness.hpp"
+#include "tensure/tensor_io.hpp"
+#include "tensure/fingerprint.hpp"
+#include "tensure/process.hpp"
+
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/resource.h>
+
+namespace taco_harness {
+
+void limit_memory()
+{
+    uint64_t bytes = memory_limit_bytes();
+    if (bytes == 0)
+        return;
+
+    struct rlimit limit = {bytes, bytes};
+    if (setrlimit(RLIMIT_AS, &limit) != 0)
+        return;
+
+    std::set_new_handler([] {
+        // Nothing is left to allocate with
+        static const char message[] = "Kernel ran out of its memory budget\n";
+        (void)!write(STDERR_FILENO, message, sizeof(message) - 1);
+        _exit(OUT_OF_MEMORY_EXIT_CODE);
+    });
+}
+
+void check_args(int argc, char* argv[], int num_inputs, const std::string& input_names)
+{
+    if (argc > num_inputs + FIRST_DATA_ARG)
+        return;
+
+    std::cerr << "Usage: " << argv[0] << " <i=N,j=M,...> ";
+    if (!input_names.empty())
+        std::cerr << input_names << " ";
+    std::cerr << "<results.tns>...\n";
+    std::exit(1);
+}
+
+std::map<char, int> read_dims(const char* arg, const std::string& idxs)
+{
+    std::map<char, int> dims;
+    std::string spec = arg;
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(pos, end - pos);
+        if (item.size() > 2 && item[1] == '=') {
+            dims[item[0]] = std::atoi(item.c_str() + 2);
+        }
+        pos = end + 1;
+    }
+
+    for (char idx : idxs) {
+        auto it = dims.find(idx);
+        if (it == dims.end() || it->second <= 0) {
+            std::cerr << "No extent for index " << idx << " in \"" << spec << "\"\n";
+            std::exit(1);
+        }
+    }
+    return dims;
+}
+
+int read_taco_file(const std::string& file_name, taco::Tensor<double>& T)
+{
+    CooBuffer data;
+    read_tensor_file(file_name, data);
+
+    std::vector<int> coord(data.rank);
+    for (size_t k = 0; k < data.nnz(); k++) {
+        coord.assign(data.coord(k), data.coord(k) + data.rank);
+        T.insert(coord, data.values[k]);
+    }
+    return 0;
+}
+
+// Nonzeros of T in iteration order
+static std::vector<int> collect_nonzeros(const taco::TensorBase& T, CooBuffer& data)
+{
+    std::vector<int> shape = T.getDimensions();
+    data.clear();
+    data.rank = shape.size();
+    for (auto& component : taco::iterate<double>(T)) {
+        for (size_t m = 0; m < shape.size(); m++) {
+            data.coords.push_back(component.first[m]);
+        }
+        data.values.push_back(component.second);
+    }
+    return shape;
+}
+
+void write_tensor(const std::string& file_name, const taco::TensorBase& T)
+{
+    CooBuffer data;
+    std::vector<int> shape = collect_nonzeros(T, data);
+    if (!write_tensor_file(file_name, shape, data)) {
+        throw std::runtime_error("Failed to write file: " + file_name);
+    }
+}
+
+static uint64_t full_results_max_nnz()
+{
+    const char* env = std::getenv("TACO_FINGERPRINT_FULL_NNZ");
+    return env ? std::strtoull(env, nullptr, 10) : FINGERPRINT_FULL_RESULTS_MAX_NNZ;
+}
+
+void write_result(const std::string& file_name, const taco::TensorBase& T)
+{
+    CooBuffer data;
+    std::vector<int> shape = collect_nonzeros(T, data);
+
+    OutputFingerprint fp(RESULTS_TOLERANCE, data.rank);
+    for (size_t k = 0; k < data.nnz(); k++) {
+        fp.add(data.coord(k), data.values[k]);
+    }
+
+    const std::string suffix = ".fp";
+    bool fingerprint_only = file_name.size() > suffix.size() &&
+                            file_name.compare(file_name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    std::string results_file = fingerprint_only ? file_name.substr(0, file_name.size() - suffix.size()) : file_name;
+
+    if (!write_fingerprint_file(fingerprint_file_of(results_file), fp)) {
+        throw std::runtime_error("Failed to write file: " + fingerprint_file_of(results_file));
+    }
+    if (fingerprint_only && fp.nnz >= full_results_max_nnz()) {
+        // No stale full results from an earlier run next to the new fingerprint
+        std::remove(results_file.c_str());
+        return;
+    }
+    if (!write_tensor_file(results_file, shape, data)) {
+        throw std::runtime_error("Failed to write file: " + results_file);
+    }
+}
+
+void write_results(int argc, char* argv[], int num_inputs, const taco::Tensor<double>& T)
+{
+    for (int arg = num_inputs + FIRST_DATA_ARG; arg < argc; arg++) {
+        write_result(argv[arg], T);
+    }
+}
+
+}
@@ -0,0 +1,429 @@
+// src/taco_wrapper/taco_runner.cpp
+//
+// Prebuilt TACO runner. Executes a TenSure kernel.json directly through TACO's
+// API (tensors and IndexExpr are built at runtime), so the fuzzer does not need
+// to generate and compile a C++ harness per mutant.
+//
+// Usage: taco_runner <kernel.json> <results.tns> [<results.tns> ...]
+//        taco_runner --batch <manifest> <status_file> [<timeout_ms>]
+//        taco_runner --fork-server
+//
+// Exit status: 0 on success, 1 on a malformed kernel or data file, 2 if TACO
+// rejects or fails the computation. Crashes inside TACO surface as signals.
+//
+// Batch mode executes every kernel listed in the manifest (one per line:
+// "<kernel.json> <results.tns> [<results.tns> ...]"). Input files are parsed
+// once and every kernel builds its own format variant from the same in-memory
+// coordinates. Each kernel runs in a forked child so a crash only affects its
+// own status, which is appended to the status file as "<line> <status>"
+// (status as above, or 128 + signal). With a timeout, a kernel still running
+// after timeout_ms is killed with its process group and recorded as
+// PROCESS_TIMEOUT, and the batch goes on with the next kernel.
+//
+// Fork-server mode loads TACO once and then forks a child per request received
+// on the control channel (protocol in taco_wrapper/fork_server.hpp).
+
+#include "tensure/formats.hpp"
+#include "taco_wrapper/fork_server.hpp"
+#include "taco_wrapper/taco_harness.hpp"
+#include "tensure/tensor_io.hpp"
+#include "tensure/process.hpp"
+#include "taco.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <filesystem>
+#include <unordered_map>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+struct RunnerError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// A parsed "Name(i,j,...)" term of the kernel expression
+struct Term {
+    char name;
+    vector<char> idxs;
+};
+
+static string strip_spaces(const string& s)
+{
+    string out;
+    for (char c : s)
+        if (!isspace(static_cast<unsigned char>(c))) out += c;
+    return out;
+}
+
+static Term parse_term(const string& token)
+{
+    size_t open = token.find('(');
+    size_t close = token.find(')');
+    if (open != 1 || close == string::npos || close < open)
+        throw RunnerError("Malformed tensor access: " + token);
+
+    Term term;
+    term.name = token[0];
+    string content = token.substr(open + 1, close - open - 1);
+    stringstream ss(content);
+    string idx;
+    while (getline(ss, idx, ',')) {
+        if (idx.size() != 1)
+            throw RunnerError("Malformed index variable in: " + token);
+        term.idxs.push_back(idx[0]);
+    }
+    return term;
+}
+
+// Split "A(i,j) = B(i,k) * C(k,j)" into the output term and the input terms
+static pair<Term, vector<Term>> parse_expression(const string& expression)
+{
+    string expr = strip_spaces(expression);
+    size_t eq = expr.find('=');
+    if (eq == string::npos)
+        throw RunnerError("Missing '=' in expression: " + expression);
+
+    Term lhs = parse_term(expr.substr(0, eq));
+    vector<Term> rhs;
+    stringstream ss(expr.substr(eq + 1));
+    string token;
+    while (getline(ss, token, '*')) {
+        if (!token.empty()) rhs.push_back(parse_term(token));
+    }
+    if (rhs.empty())
+        throw RunnerError("Empty right-hand side in expression: " + expression);
+
+    return {lhs, rhs};
+}
+
+static taco::Format to_taco_format(const vector<TensorFormat>& fmt)
+{
+    vector<taco::ModeFormatPack> modes;
+    for (auto f : fmt) {
+        modes.push_back(f == TensorFormat::tsDense ? taco::ModeFormatPack(taco::Dense)
+                                                   : taco::ModeFormatPack(taco::Sparse));
+    }
+    return taco::Format(modes);
+}
+
+// Coordinates and values of each input file, shared by every kernel reading it
+using DataCache = unordered_map<string, CooBuffer>;
+
+static const CooBuffer& load_tensor_file(const string& file_name, DataCache& cache)
+{
+    auto it = cache.find(file_name);
+    if (it == cache.end()) {
+        it = cache.emplace(file_name, CooBuffer()).first;
+        try {
+            read_tensor_file(file_name, it->second);
+        } catch (...) {
+            cache.erase(it);
+            throw;
+        }
+    }
+    return it->second;
+}
+
+static string data_file_path(const tsKernel& kernel, const tsTensor& t)
+{
+    auto it = kernel.dataFileNames.find(string(1, t.name));
+    if (it == kernel.dataFileNames.end() || it->second == "-")
+        return "";
+    return fs::absolute(it->second).string();
+}
+
+/**
+ * Build, compute and write one kernel.
+ * @return 0 on success, 1 for a malformed kernel or data file, 2 if TACO fails
+ */
+static int run_kernel(const string& spec_file, const vector<string>& results_files, DataCache& cache)
+{
+    tsKernel kernel;
+    map<char, taco::TensorBase> tensors;
+    map<char, taco::IndexVar> index_vars;
+    Term lhs;
+    vector<Term> rhs;
+
+    // 1. Build the TACO tensors and load their data
+    try {
+        kernel.loadJson(spec_file);
+        if (kernel.tensors.empty() || kernel.computations.empty())
+            throw RunnerError("Empty kernel specification: " + spec_file);
+
+        for (auto& t : kernel.tensors) {
+            taco::TensorBase T(string(1, t.name), taco::Float64, t.shape, to_taco_format(t.storageFormat));
+
+            string data_file = data_file_path(kernel, t);
+            if (!data_file.empty()) {
+                const CooBuffer& data = load_tensor_file(data_file, cache);
+                vector<int> coord(data.rank);
+                for (size_t k = 0; k < data.nnz(); k++) {
+                    coord.assign(data.coord(k), data.coord(k) + data.rank);
+                    T.insert(coord, data.values[k]);
+                }
+                T.pack();
+            }
+            tensors.emplace(t.name, T);
+
+            for (char idx : t.idxs) {
+                if (!index_vars.count(idx))
+                    index_vars.emplace(idx, taco::IndexVar(string(1, idx)));
+            }
+        }
+
+        tie(lhs, rhs) = parse_expression(kernel.computations[0].expressions);
+    } catch (const exception& e) {
+        cerr << "[taco_runner] " << e.what() << "\n";
+        return 1;
+    }
+
+    // 2. Build the index expression and let TACO compile, assemble and compute it
+    try {
+        auto access = [&](const Term& term) {
+            auto it = tensors.find(term.name);
+            if (it == tensors.end())
+                throw RunnerError(string("Tensor not declared in kernel: ") + term.name);
+
+            vector<taco::IndexVar> vars;
+            for (char idx : term.idxs) {
+                if (!index_vars.count(idx))
+                    index_vars.emplace(idx, taco::IndexVar(string(1, idx)));
+                vars.push_back(index_vars.at(idx));
+            }
+            return it->second(vars);
+        };
+
+        taco::IndexExpr expr = access(rhs[0]);
+        for (size_t i = 1; i < rhs.size(); i++) {
+            expr = expr * access(rhs[i]);
+        }
+        access(lhs) = expr;
+
+        taco::TensorBase& out = tensors.at(lhs.name);
+        out.compile();
+        // The kernel runs under the memory budget, the compiler TACO invoked above does not
+        taco_harness::limit_memory();
+        out.assemble();
+        out.compute();
+
+        for (auto& results_file : results_files) {
+            taco_harness::write_result(fs::absolute(results_file).string(), out);
+        }
+    } catch (const RunnerError& e) {
+        cerr << "[taco_runner] " << e.what() << "\n";
+        return 1;
+    } catch (const exception& e) {
+        cerr << "[taco_runner] TACO error: " << e.what() << "\n";
+        return 2;
+    }
+
+    return 0;
+}
+
+// Reap a batch child into wstatus, first killing its process group if it is still running
+// timeout_ms after the call (0: no deadline). Returns whether it was killed.
+static bool wait_batch_child(pid_t pid, uint64_t timeout_ms, int& wstatus)
+{
+    using namespace std::chrono;
+
+    bool timed_out = false;
+    if (timeout_ms > 0) {
+        auto deadline = steady_clock::now() + milliseconds(timeout_ms);
+        auto delay = milliseconds(1);
+        for (;;) {
+            pid_t ret = waitpid(pid, &wstatus, WNOHANG);
+            if (ret == pid) return false;
+            if (ret < 0 && errno != EINTR) return false;
+            auto now = steady_clock::now();
+            if (now >= deadline) {
+                kill(-pid, SIGKILL);
+                timed_out = true;
+                break;
+            }
+            this_thread::sleep_for(min<steady_clock::duration>(delay, deadline - now));
+            delay = min(delay * 2, milliseconds(50));
+        }
+    }
+    while (waitpid(pid, &wstatus, 0) < 0 && errno == EINTR) {}
+    return timed_out;
+}
+
+static int run_batch(const string& manifest_file, const string& status_file, uint64_t timeout_ms)
+{
+    ifstream manifest(manifest_file);
+    if (!manifest.is_open()) {
+        cerr << "[taco_runner] Failed to open batch manifest: " << manifest_file << "\n";
+        return 1;
+    }
+
+    vector<pair<string, vector<string>>> jobs;
+    string line;
+    while (getline(manifest, line)) {
+        istringstream iss(line);
+        string spec_file, results_file;
+        if (!(iss >> spec_file)) continue;
+        vector<string> results_files;
+        while (iss >> results_file) results_files.push_back(results_file);
+        jobs.emplace_back(spec_file, results_files);
+    }
+
+    // Parse every input once up front, so the forked children share the coordinates
+    DataCache cache;
+    for (auto& job : jobs) {
+        try {
+            tsKernel kernel;
+            kernel.loadJson(job.first);
+            for (auto& t : kernel.tensors) {
+                string data_file = data_file_path(kernel, t);
+                if (!data_file.empty()) load_tensor_file(data_file, cache);
+            }
+        } catch (const exception&) {
+            // Reported by the kernel's own run below
+        }
+    }
+
+    ofstream status_out(status_file, ios::app);
+    if (!status_out.is_open()) {
+        cerr << "[taco_runner] Failed to open status file: " << status_file << "\n";
+        return 1;
+    }
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        cout.flush();
+        pid_t pid = fork();
+        if (pid < 0) {
+            cerr << "[taco_runner] fork failed for kernel " << jobs[i].first << "\n";
+            status_out << i << " " << -1 << endl;
+            continue;
+        }
+        if (pid == 0) {
+            // Its own group, so the deadline also kills the compiler TACO may have started
+            setpgid(0, 0);
+            int code = run_kernel(jobs[i].first, jobs[i].second, cache);
+            cout.flush();
+            _exit(code);
+        }
+        setpgid(pid, pid);
+
+        int wstatus = 0;
+        if (wait_batch_child(pid, timeout_ms, wstatus)) {
+            cerr << "[taco_runner] kernel " << jobs[i].first << " killed after " << timeout_ms << " ms\n";
+            status_out << i << " " << PROCESS_TIMEOUT << endl;
+            continue;
+        }
+        int code = WIFSIGNALED(wstatus) ? 128 + WTERMSIG(wstatus) : WEXITSTATUS(wstatus);
+        status_out << i << " " << kernel_status(code) << endl;
+    }
+
+    return 0;
+}
+
+static bool read_all(int fd, void* buf, size_t len)
+{
+    char* p = static_cast<char*>(buf);
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool write_all(int fd, const void* buf, size_t len)
+{
+    const char* p = static_cast<const char*>(buf);
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static int run_fork_server()
+{
+    const int ctl_fd = taco_wrapper::FORKSRV_FD;
+    const int st_fd = taco_wrapper::FORKSRV_FD + 1;
+
+    uint32_t hello = 0;
+    if (!write_all(st_fd, &hello, sizeof(hello))) {
+        cerr << "[taco_runner] --fork-server needs the control channels on fds "
+             << ctl_fd << " and " << st_fd << "\n";
+        return 1;
+    }
+
+    // Serve until the client closes the control channel
+    uint32_t len;
+    while (read_all(ctl_fd, &len, sizeof(len))) {
+        string request(len, '\0');
+        if (!read_all(ctl_fd, &request[0], len)) break;
+
+        istringstream iss(request);
+        string spec_file, results_file;
+        iss >> spec_file;
+        vector<string> results_files;
+        while (iss >> results_file) results_files.push_back(results_file);
+
+        cout.flush();
+        cerr.flush();
+        int32_t pid = fork();
+        if (pid == 0) {
+            setpgid(0, 0);
+            close(ctl_fd);
+            close(st_fd);
+            DataCache cache;
+            int code = run_kernel(spec_file, results_files, cache);
+            cout.flush();
+            _exit(code);
+        }
+
+        // The child leads its own process group, so the client can kill it (and anything
+        // TACO spawned) at its deadline; set it here as well so the pid sent is already a group
+        if (pid > 0) setpgid(pid, pid);
+        if (!write_all(st_fd, &pid, sizeof(pid))) break;
+
+        int wstatus = 0;
+        if (pid > 0) {
+            while (waitpid(pid, &wstatus, 0) < 0 && errno == EINTR) {}
+        }
+        int32_t status = wstatus;
+        if (!write_all(st_fd, &status, sizeof(status))) break;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if ((argc == 4 || argc == 5) && string(argv[1]) == "--batch") {
+        return run_batch(argv[2], argv[3], argc == 5 ? strtoull(argv[4], nullptr, 10) : 0);
+    }
+    if (argc == 2 && string(argv[1]) == "--fork-server") {
+        return run_fork_server();
+    }
+
+    if (argc < 3) {
+        cerr << "Usage: " << argv[0] << " <kernel.json> <results.tns> [<results.tns> ...]\n"
+             << "       " << argv[0] << " --batch <manifest> <status_file> [<timeout_ms>]\n"
+             << "       " << argv[0] << " --fork-server\n";
+        return 1;
+    }
+
+    DataCache cache;
+    return run_kernel(argv[1], vector<string>(argv + 2, argv + argc), cache);
+}
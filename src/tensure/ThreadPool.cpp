@@ -1,49 +1,208 @@
 #include "tensure/ThreadPool.hpp"
 
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+// Pool and deque index of the current thread, if it is a pool worker
+static thread_local const ThreadPool* tls_pool = nullptr;
+static thread_local size_t tls_worker = 0;
+
+string ThreadPoolMetrics::to_string() const {
+    ostringstream oss;
+    oss << std::fixed << std::setprecision(1)
+        << "queued " << queued;
+    if (capacity > 0) oss << "/" << capacity;
+    oss << ", running " << running
+        << ", steals " << steals
+        << ", wait avg " << avg_wait_ms << " ms max " << max_wait_ms << " ms";
+    return oss.str();
+}
+
+// Take the highest-priority task available: own deque first, then steal from the others
+bool ThreadPool::take_task(size_t idx, Entry& entry, TaskPriority lowest) {
+    const size_t n = queues.size();
+    bool found = false;
+
+    for (size_t prio = 0; prio <= static_cast<size_t>(lowest) && !found; ++prio) {
+        {
+            WorkerQueue& own = *queues[idx];
+            std::lock_guard<std::mutex> lock(own.mtx);
+            if (!own.tasks[prio].empty()) {
+                entry = std::move(own.tasks[prio].front());
+                own.tasks[prio].pop_front();
+                found = true;
+            }
+        }
+        for (size_t k = 1; k < n && !found; ++k) {
+            WorkerQueue& victim = *queues[(idx + k) % n];
+            std::lock_guard<std::mutex> lock(victim.mtx);
+            if (!victim.tasks[prio].empty()) {
+                entry = std::move(victim.tasks[prio].back());
+                victim.tasks[prio].pop_back();
+                found = true;
+                steals++;
+            }
+        }
+    }
+    if (!found) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        pending--;
+    }
+    space_available.notify_one();
+    return true;
+}
+
+void ThreadPool::run_entry(Entry& entry) {
+    auto wait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - entry.enqueued).count();
+    total_wait_us += wait;
+    uint64_t prev_max = max_wait_us.load();
+    while (static_cast<uint64_t>(wait) > prev_max && !max_wait_us.compare_exchange_weak(prev_max, wait)) {}
+
+    // Execute task (outside any lock)
+    running++;
+    entry.task();
+    running--;
+    executed++;
+}
+
 // The thread's main loop function
-void ThreadPool::worker_loop() {
+void ThreadPool::worker_loop(size_t idx) {
+    tls_pool = this;
+    tls_worker = idx;
+
     for (;;) {
-        Task task;
-        {
-            // A. Acquire lock to check queue
-            std::unique_lock<std::mutex> lock(this->queue_mutex);
+        Entry entry;
+        if (take_task(idx, entry)) {
+            run_entry(entry);
+            continue;
+        }
+
+        // Wait until work is queued OR the pool is stopped
+        std::unique_lock<std::mutex> lock(this->state_mutex);
+        this->work_available.wait(lock,
+            [this]{ return this->stop || this->pending > 0; });
+
+        // If stopped and nothing is queued, exit thread loop
+        if (this->stop && this->pending == 0)
+            return;
+    }
+}
 
-            // B. Wait until queue is NOT empty OR the pool is stopped
-            this->condition.wait(lock,
-                [this]{ return this->stop || !this->tasks.empty(); });
+void ThreadPool::enqueue(Task task, TaskPriority priority) {
+    const bool from_worker = (tls_pool == this);
+    {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        if (!from_worker && capacity > 0) {
+            space_available.wait(lock, [this]{ return stop || pending < capacity; });
+        }
+        if (stop)
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        // Reserved before the push so a worker taking the task can never see pending == 0
+        pending++;
+    }
+    submitted++;
 
-            // C. If stopped and queue is empty, exit thread loop
-            if (this->stop && this->tasks.empty())
-                return;
+    size_t target = from_worker ? tls_worker : next_queue++ % queues.size();
+    {
+        WorkerQueue& queue = *queues[target];
+        std::lock_guard<std::mutex> lock(queue.mtx);
+        queue.tasks[static_cast<size_t>(priority)].push_back({std::move(task), std::chrono::steady_clock::now()});
+    }
+    // Notify one waiting worker thread that new work is available
+    work_available.notify_one();
+}
 
-            // D. Take task from queue
-            task = std::move(this->tasks.front());
-            this->tasks.pop();
-        } // Lock automatically released here
+bool ThreadPool::run_pending_task(TaskPriority lowest) {
+    // Outside the pool there is no own deque; scanning from 0 is as good as any
+    size_t idx = (tls_pool == this) ? tls_worker : 0;
+    Entry entry;
+    if (!take_task(idx, entry, lowest))
+        return false;
+    run_entry(entry);
+    return true;
+}
 
-        // E. Execute task (outside the lock)
-        task();
+ThreadPoolMetrics ThreadPool::metrics() const {
+    ThreadPoolMetrics m;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        m.queued = pending;
     }
+    m.capacity = capacity;
+    m.running = running.load();
+    m.submitted = submitted.load();
+    m.executed = executed.load();
+    m.steals = steals.load();
+    uint64_t started = m.executed + m.running;
+    m.avg_wait_ms = started ? total_wait_us.load() / 1e3 / started : 0;
+    m.max_wait_ms = max_wait_us.load() / 1e3;
+    return m;
 }
 
 // Constructor Implementation
-ThreadPool::ThreadPool(size_t threads) : stop(false) {
+ThreadPool::ThreadPool(size_t threads, size_t capacity) : capacity(capacity), stop(false) {
     if (threads == 0) threads = 1; // Ensure at least one thread
 
     for (size_t i = 0; i < threads; ++i) {
-        workers.emplace_back(&ThreadPool::worker_loop, this);
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
     }
 }
 
 // Destructor Implementation
 ThreadPool::~ThreadPool() {
     {
-        std::unique_lock<std::mutex> lock(queue_mutex);
+        std::unique_lock<std::mutex> lock(state_mutex);
         stop = true;
     }
-    condition.notify_all(); // Wake up all waiting threads
+    work_available.notify_all(); // Wake up all waiting threads
+    space_available.notify_all();
     for(std::thread &worker: workers) {
         if(worker.joinable())
             worker.join(); // Wait for each thread to finish
     }
-}
\ No newline at end of file
+}
+
+void TaskGroup::run(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        outstanding++;
+    }
+    try {
+        pool.enqueue([this, task = std::move(task)]() {
+            try {
+                task();
+            } catch (...) {}
+            // Notify under the lock: once outstanding hits 0 the group may be destroyed
+            std::lock_guard<std::mutex> lock(mtx);
+            outstanding--;
+            done.notify_all();
+        }, priority);
+    } catch (...) {
+        // Not queued (the pool is stopping): the task will never count itself down
+        std::lock_guard<std::mutex> lock(mtx);
+        outstanding--;
+        done.notify_all();
+        throw;
+    }
+}
+
+void TaskGroup::wait() {
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (outstanding == 0) return;
+        }
+        if (pool.run_pending_task(priority)) continue;
+
+        // Nothing to help with: the remaining tasks are running on other threads. The
+        // timeout picks up tasks that get queued meanwhile (by them, or by other groups).
+        std::unique_lock<std::mutex> lock(mtx);
+        done.wait_for(lock, std::chrono::milliseconds(5), [this]{ return outstanding == 0; });
+    }
+}
@@ -0,0 +1,335 @@
+#include "tensure/einsum.hpp"
+#include "tensure/fingerprint.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+// Intermediate result: data holds one coordinate per index of idxs
+struct Factor {
+    vector<char> idxs;
+    CooBuffer data;
+};
+
+// Row-major linearization of a subset of a factor's coordinates
+struct IndexKey {
+    vector<uint32_t> pos;     // positions in the factor's coordinates
+    vector<uint64_t> extent;
+
+    IndexKey(const vector<char>& idxs, const vector<char>& of, const map<char, int>& dims)
+    {
+        uint64_t total = 1;
+        for (char c : of) {
+            pos.push_back(find(idxs.begin(), idxs.end(), c) - idxs.begin());
+            extent.push_back(dims.at(c));
+            if (__builtin_mul_overflow(total, extent.back(), &total)) {
+                throw runtime_error("Einsum index space too large");
+            }
+        }
+    }
+
+    uint64_t key(const int32_t* c) const
+    {
+        uint64_t k = 0;
+        for (size_t m = 0; m < pos.size(); m++) {
+            k = k * extent[m] + uint64_t(c[pos[m]]);
+        }
+        return k;
+    }
+
+    void decode(uint64_t k, int32_t* c) const
+    {
+        for (size_t m = pos.size(); m-- > 0;) {
+            c[m] = static_cast<int32_t>(k % extent[m]);
+            k /= extent[m];
+        }
+    }
+};
+
+using Accumulator = unordered_map<uint64_t, double>;
+
+// Nonzeros of acc in key order, as coordinates over key's indices
+static void to_factor(const Accumulator& acc, const IndexKey& key, Factor& out)
+{
+    vector<pair<uint64_t, double>> entries;
+    entries.reserve(acc.size());
+    for (auto& kv : acc) {
+        if (kv.second != 0.0) entries.push_back(kv);
+    }
+    sort(entries.begin(), entries.end(), [](auto& a, auto& b) { return a.first < b.first; });
+
+    out.data.clear();
+    out.data.rank = out.idxs.size();
+    out.data.coords.resize(entries.size() * out.data.rank);
+    out.data.values.reserve(entries.size());
+    for (size_t k = 0; k < entries.size(); k++) {
+        key.decode(entries[k].first, out.data.coords.data() + k * out.data.rank);
+        out.data.values.push_back(entries[k].second);
+    }
+}
+
+// Sum x over every index not in keep; the result's indices follow keep's order
+static Factor project(const Factor& x, const vector<char>& keep, const map<char, int>& dims)
+{
+    Factor out;
+    out.idxs = keep;
+    IndexKey key(x.idxs, keep, dims);
+    Accumulator acc;
+    for (size_t k = 0; k < x.data.nnz(); k++) {
+        acc[key.key(x.data.coord(k))] += x.data.values[k];
+    }
+    to_factor(acc, key, out);
+    return out;
+}
+
+// Indices of the pair's product that are still needed; x's first, then y's
+static vector<char> joined_indices(const Factor& x, const Factor& y, const vector<char>& keep)
+{
+    vector<char> idxs;
+    for (const Factor* f : {&x, &y}) {
+        for (char c : f->idxs) {
+            if (find(keep.begin(), keep.end(), c) != keep.end() && find(idxs.begin(), idxs.end(), c) == idxs.end()) {
+                idxs.push_back(c);
+            }
+        }
+    }
+    return idxs;
+}
+
+// Sum of x * y over the indices outside keep (hash join on the shared indices)
+static Factor contract(const Factor& x, const Factor& y, const vector<char>& keep, const map<char, int>& dims, unsigned threads)
+{
+    // Hash the smaller side, probe with the larger one
+    const Factor& build = x.data.nnz() <= y.data.nnz() ? x : y;
+    const Factor& probe = &build == &x ? y : x;
+
+    vector<char> shared;
+    for (char c : build.idxs) {
+        if (find(probe.idxs.begin(), probe.idxs.end(), c) != probe.idxs.end()) shared.push_back(c);
+    }
+    IndexKey build_key(build.idxs, shared, dims), probe_key(probe.idxs, shared, dims);
+
+    // Build entries grouped by join key: table maps a key to its range in order
+    vector<pair<uint64_t, uint32_t>> order;
+    order.reserve(build.data.nnz());
+    for (size_t k = 0; k < build.data.nnz(); k++) {
+        order.emplace_back(build_key.key(build.data.coord(k)), static_cast<uint32_t>(k));
+    }
+    sort(order.begin(), order.end());
+    unordered_map<uint64_t, pair<size_t, size_t>> table;
+    for (size_t i = 0; i < order.size();) {
+        size_t j = i;
+        while (j < order.size() && order[j].first == order[i].first) j++;
+        table[order[i].first] = {i, j};
+        i = j;
+    }
+
+    // Each result coordinate is taken from the build or the probe side
+    Factor out;
+    out.idxs = joined_indices(x, y, keep);
+    IndexKey out_key(out.idxs, out.idxs, dims);
+    vector<pair<bool, uint32_t>> source;
+    for (char c : out.idxs) {
+        auto it = find(build.idxs.begin(), build.idxs.end(), c);
+        if (it != build.idxs.end()) source.emplace_back(true, it - build.idxs.begin());
+        else source.emplace_back(false, find(probe.idxs.begin(), probe.idxs.end(), c) - probe.idxs.begin());
+    }
+
+    auto join = [&](size_t begin, size_t end, Accumulator& acc) {
+        vector<int32_t> c(out.idxs.size());
+        for (size_t k = begin; k < end; k++) {
+            auto it = table.find(probe_key.key(probe.data.coord(k)));
+            if (it == table.end()) continue;
+            const int32_t* pc = probe.data.coord(k);
+            for (size_t i = it->second.first; i < it->second.second; i++) {
+                uint32_t b = order[i].second;
+                const int32_t* bc = build.data.coord(b);
+                for (size_t m = 0; m < source.size(); m++) {
+                    c[m] = source[m].first ? bc[source[m].second] : pc[source[m].second];
+                }
+                acc[out_key.key(c.data())] += probe.data.values[k] * build.data.values[b];
+            }
+        }
+    };
+
+    size_t n = probe.data.nnz();
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    if (n < PARALLEL_EINSUM_MIN_NNZ) threads = 1;
+
+    // Partial sums per thread, merged in thread order so the result does not depend on timing
+    vector<Accumulator> partial(threads);
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; t++) {
+        workers.emplace_back(join, n * t / threads, n * (t + 1) / threads, ref(partial[t]));
+    }
+    join(0, n / threads, partial[0]);
+    for (auto& w : workers) w.join();
+    for (unsigned t = 1; t < threads; t++) {
+        for (auto& kv : partial[t]) partial[0][kv.first] += kv.second;
+    }
+
+    to_factor(partial[0], out_key, out);
+    return out;
+}
+
+// Indices used by the output or by a factor other than skip_a and skip_b
+static vector<char> needed_indices(const vector<Factor>& factors, size_t skip_a, size_t skip_b, const vector<char>& out_idxs)
+{
+    vector<char> keep = out_idxs;
+    for (size_t f = 0; f < factors.size(); f++) {
+        if (f == skip_a || f == skip_b) continue;
+        for (char c : factors[f].idxs) {
+            if (find(keep.begin(), keep.end(), c) == keep.end()) keep.push_back(c);
+        }
+    }
+    return keep;
+}
+
+// Factor of a term; repeated indices keep only the diagonal
+static Factor load_term(const EinsumTerm& term)
+{
+    Factor f;
+    vector<uint32_t> first;  // per mode, the first mode with the same index
+    for (size_t m = 0; m < term.idxs.size(); m++) {
+        auto it = find(f.idxs.begin(), f.idxs.end(), term.idxs[m]);
+        if (it == f.idxs.end()) {
+            first.push_back(m);
+            f.idxs.push_back(term.idxs[m]);
+        } else {
+            first.push_back(find(term.idxs.begin(), term.idxs.end(), term.idxs[m]) - term.idxs.begin());
+        }
+    }
+    if (term.data.nnz() > 0 && term.data.rank != term.idxs.size()) {
+        throw runtime_error("Einsum term has " + to_string(term.idxs.size()) + " indices but rank " + to_string(term.data.rank) + " data");
+    }
+
+    f.data.rank = f.idxs.size();
+    for (size_t k = 0; k < term.data.nnz(); k++) {
+        const int32_t* c = term.data.coord(k);
+        if (term.data.values[k] == 0.0) continue;
+        bool diagonal = true;
+        for (size_t m = 0; m < term.idxs.size(); m++) diagonal = diagonal && c[m] == c[first[m]];
+        if (!diagonal) continue;
+        for (size_t m = 0; m < term.idxs.size(); m++) {
+            if (first[m] == m) f.data.coords.push_back(c[m]);
+        }
+        f.data.values.push_back(term.data.values[k]);
+    }
+    return f;
+}
+
+static double dense_size(const vector<char>& idxs, const map<char, int>& dims)
+{
+    double size = 1.0;
+    for (char c : idxs) size *= dims.at(c);
+    return size;
+}
+
+void evaluate_einsum(const vector<EinsumTerm>& terms, const vector<char>& out_idxs, const map<char, int>& dims,
+                     CooBuffer& out, unsigned threads)
+{
+    vector<Factor> factors;
+    for (auto& term : terms) factors.push_back(load_term(term));
+    for (char c : out_idxs) {
+        bool found = any_of(factors.begin(), factors.end(), [&](const Factor& f) {
+            return find(f.idxs.begin(), f.idxs.end(), c) != f.idxs.end();
+        });
+        if (!found) throw runtime_error(string("Output index ") + c + " appears in no einsum term");
+    }
+
+    // Sum out the indices only one factor has before joining anything
+    for (size_t f = 0; f < factors.size(); f++) {
+        vector<char> needed = needed_indices(factors, f, f, out_idxs), keep;
+        for (char c : factors[f].idxs) {
+            if (find(needed.begin(), needed.end(), c) != needed.end()) keep.push_back(c);
+        }
+        if (keep.size() < factors[f].idxs.size()) factors[f] = project(factors[f], keep, dims);
+    }
+
+    while (factors.size() > 1) {
+        // Cheapest pair: smallest expected join size, nnz(x) * nnz(y) / (points of the shared indices)
+        size_t best_a = 0, best_b = 1;
+        double best_cost = INFINITY;
+        for (size_t a = 0; a < factors.size(); a++) {
+            for (size_t b = a + 1; b < factors.size(); b++) {
+                vector<char> shared;
+                for (char c : factors[a].idxs) {
+                    if (find(factors[b].idxs.begin(), factors[b].idxs.end(), c) != factors[b].idxs.end()) shared.push_back(c);
+                }
+                double cost = double(factors[a].data.nnz()) * double(factors[b].data.nnz()) / dense_size(shared, dims);
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_a = a;
+                    best_b = b;
+                }
+            }
+        }
+
+        Factor joined = contract(factors[best_a], factors[best_b], needed_indices(factors, best_a, best_b, out_idxs), dims, threads);
+        factors.erase(factors.begin() + best_b);
+        factors[best_a] = move(joined);
+    }
+
+    Factor result = project(factors[0], out_idxs, dims);
+    out = move(result.data);
+}
+
+// "B(i,k)" -> 'B'
+static char term_name(const string& term)
+{
+    size_t begin = term.find_first_not_of(" \t");
+    if (begin == string::npos) throw runtime_error("Empty einsum term");
+    return term[begin];
+}
+
+void evaluate_kernel(const tsKernel& kernel, const string& results_file, unsigned threads)
+{
+    if (kernel.tensors.empty() || kernel.computations.empty()) throw runtime_error("Kernel has no computation");
+
+    const string& expr = kernel.computations[0].expressions;
+    size_t eq = expr.find('=');
+    if (eq == string::npos) throw runtime_error("Malformed expression: " + expr);
+
+    auto tensor_of = [&](char name) -> const tsTensor& {
+        for (auto& t : kernel.tensors) {
+            if (t.name == name) return t;
+        }
+        throw runtime_error(string("Unknown tensor ") + name + " in " + expr);
+    };
+
+    map<char, int> dims;
+    for (auto& t : kernel.tensors) {
+        for (size_t m = 0; m < t.idxs.size() && m < t.shape.size(); m++) dims[t.idxs[m]] = t.shape[m];
+    }
+
+    vector<EinsumTerm> terms;
+    size_t begin = eq + 1;
+    while (begin <= expr.size()) {
+        size_t end = expr.find('*', begin);
+        if (end == string::npos) end = expr.size();
+        const tsTensor& t = tensor_of(term_name(expr.substr(begin, end - begin)));
+
+        auto file = kernel.dataFileNames.find(string(1, t.name));
+        if (file == kernel.dataFileNames.end()) throw runtime_error(string("No data file for tensor ") + t.name);
+        EinsumTerm term;
+        term.idxs = t.idxs;
+        read_tensor_file(file->second, term.data);
+        terms.push_back(move(term));
+        begin = end + 1;
+    }
+
+    const tsTensor& lhs = tensor_of(term_name(expr.substr(0, eq)));
+    CooBuffer out;
+    evaluate_einsum(terms, lhs.idxs, dims, out, threads);
+
+    if (!write_tensor_file(results_file, lhs.shape, out)) {
+        throw runtime_error("Failed to write file: " + results_file);
+    }
+    OutputFingerprint fp(REFERENCE_FINGERPRINT_TOLERANCE, out.rank);
+    for (size_t k = 0; k < out.nnz(); k++) fp.add(out.coord(k), out.values[k]);
+    if (!write_fingerprint_file(fingerprint_file_of(results_file), fp)) {
+        throw runtime_error("Failed to write file: " + fingerprint_file_of(results_file));
+    }
+}
@@ -0,0 +1,82 @@
+#include "tensure/fingerprint.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+static constexpr int FINGERPRINT_VERSION = 1;
+
+// splitmix64 finalizer
+static uint64_t mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+void OutputFingerprint::add(const int* coord, double value)
+{
+    if (value == 0.0) return;
+
+    // Index of the nearest multiple of tol; -0.0 and 0.0 hash alike
+    double quantum = tol > 0.0 ? nearbyint(value / tol) : value;
+    if (quantum == 0.0) quantum = 0.0;
+    uint64_t bits;
+    memcpy(&bits, &quantum, sizeof(bits));
+
+    uint64_t h = mix(0x9e3779b97f4a7c15ULL + rank);
+    for (uint32_t m = 0; m < rank; m++) {
+        h = mix(h ^ uint64_t(uint32_t(coord[m])));
+        mode_sums[m] += uint64_t(int64_t(coord[m]));
+    }
+    hash += mix(h ^ bits);
+    nnz++;
+}
+
+bool OutputFingerprint::operator==(const OutputFingerprint& other) const
+{
+    return tol == other.tol && rank == other.rank && nnz == other.nnz && hash == other.hash &&
+           mode_sums == other.mode_sums;
+}
+
+string OutputFingerprint::to_string() const
+{
+    ostringstream os;
+    os.precision(17);
+    os << "TSFP " << FINGERPRINT_VERSION << " " << tol << " " << rank << " " << nnz << " " << hash;
+    for (uint64_t sum : mode_sums) os << " " << sum;
+    return os.str();
+}
+
+string fingerprint_file_of(const string& results_file)
+{
+    return results_file + ".fp";
+}
+
+bool write_fingerprint_file(const string& path, const OutputFingerprint& fp)
+{
+    ofstream out(path);
+    out << fp.to_string() << "\n";
+    out.close();
+    return !out.fail();
+}
+
+bool read_fingerprint_file(const string& path, OutputFingerprint& fp)
+{
+    ifstream in(path);
+    string magic;
+    int version = 0;
+    if (!(in >> magic >> version >> fp.tol >> fp.rank >> fp.nnz >> fp.hash) || magic != "TSFP" ||
+        version != FINGERPRINT_VERSION || fp.rank > 64) {
+        return false;
+    }
+    fp.mode_sums.assign(fp.rank, 0);
+    for (auto& sum : fp.mode_sums) {
+        if (!(in >> sum)) return false;
+    }
+    return true;
+}
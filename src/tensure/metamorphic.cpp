@@ -0,0 +1,67 @@
+#include "tensure/metamorphic.hpp"
+#include "tensure/fingerprint.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+void transform_tensor(const tsOutputTransform& transform, CooBuffer& data)
+{
+    switch (transform.kind) {
+    case tsOutputTransform::Scale:
+        for (double& v : data.values) v *= transform.factor;
+        break;
+
+    case tsOutputTransform::Permute: {
+        // An empty text file has no rank
+        uint32_t rank = data.rank;
+        if (data.nnz() == 0) break;
+        if (transform.perm.size() != rank) throw invalid_argument("Permutation does not match the tensor's rank");
+        vector<int32_t> c(rank);
+        for (size_t k = 0; k < data.nnz(); k++) {
+            int32_t* coord = data.coords.data() + k * rank;
+            for (uint32_t m = 0; m < rank; m++) c[m] = coord[transform.perm[m]];
+            copy(c.begin(), c.end(), coord);
+        }
+        if (data.shape.size() == rank) {
+            vector<int> shape(rank);
+            for (uint32_t m = 0; m < rank; m++) shape[m] = data.shape[transform.perm[m]];
+            data.shape = shape;
+        }
+        break;
+    }
+
+    case tsOutputTransform::Slice: {
+        uint32_t rank = data.rank;
+        if (data.nnz() == 0) break;
+        if (transform.mode < 0 || uint32_t(transform.mode) >= rank) throw invalid_argument("Slice mode does not match the tensor's rank");
+        size_t n = 0;
+        for (size_t k = 0; k < data.nnz(); k++) {
+            const int32_t* coord = data.coord(k);
+            if (!binary_search(transform.keep.begin(), transform.keep.end(), coord[transform.mode])) continue;
+            copy(coord, coord + rank, data.coords.begin() + n * rank);
+            data.values[n++] = data.values[k];
+        }
+        data.coords.resize(n * rank);
+        data.values.resize(n);
+        break;
+    }
+    }
+}
+
+void derive_expected_output(const vector<tsOutputTransform>& transforms, const string& ref_file, const string& expected_file)
+{
+    CooBuffer data;
+    read_tensor_file(ref_file, data);
+    for (auto& transform : transforms) {
+        transform_tensor(transform, data);
+    }
+
+    if (!write_tensor_file(expected_file, data.shape, data)) {
+        throw runtime_error("Failed to write file: " + expected_file);
+    }
+    OutputFingerprint fp(REFERENCE_FINGERPRINT_TOLERANCE, data.rank);
+    for (size_t k = 0; k < data.nnz(); k++) fp.add(data.coord(k), data.values[k]);
+    if (!write_fingerprint_file(fingerprint_file_of(expected_file), fp)) {
+        throw runtime_error("Failed to write file: " + fingerprint_file_of(expected_file));
+    }
+}
@@ -0,0 +1,136 @@
+#include "tensure/process.hpp"
+
+#include <chrono>
+#include <thread>
+#include <sstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <csignal>
+#include <poll.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+extern char** environ;
+
+int ProcessResult::status() const
+{
+    if (!spawned) return -1;
+    if (timed_out) return PROCESS_TIMEOUT;
+    if (signal != 0) return 128 + signal;
+    return exit_code;
+}
+
+string ProcessResult::summary() const
+{
+    ostringstream oss;
+    if (!spawned) oss << "not started";
+    else if (timed_out) oss << "killed at deadline";
+    else if (signal != 0) oss << "signal " << signal;
+    else oss << "exit " << exit_code;
+    oss << " in " << static_cast<long>(wall_ms) << " ms (cpu " << static_cast<long>(cpu_ms)
+        << " ms, rss " << peak_rss_kb << " KB)";
+    return oss.str();
+}
+
+static int open_pidfd(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+// Wait until pid has exited (without reaping it) or the deadline passes
+static bool wait_for_exit(pid_t pid, chrono::steady_clock::time_point deadline)
+{
+    using namespace std::chrono;
+
+    int pidfd = open_pidfd(pid);
+    if (pidfd >= 0) {
+        bool exited = false;
+        while (!exited) {
+            auto remaining = duration_cast<milliseconds>(deadline - steady_clock::now()).count();
+            if (remaining <= 0) break;
+            pollfd pfd{pidfd, POLLIN, 0};
+            int ret = poll(&pfd, 1, static_cast<int>(min<long long>(remaining, INT32_MAX)));
+            if (ret > 0) exited = true;
+            else if (ret < 0 && errno != EINTR) break;
+        }
+        close(pidfd);
+        if (exited) return true;
+    }
+
+    // No pidfd (old kernel) or poll failed: poll the process state with backoff
+    auto delay = milliseconds(1);
+    while (true) {
+        siginfo_t info{};
+        if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == pid)
+            return true;
+        auto now = steady_clock::now();
+        if (now >= deadline) return false;
+        this_thread::sleep_for(min<steady_clock::duration>(delay, deadline - now));
+        delay = min(delay * 2, milliseconds(50));
+    }
+}
+
+ProcessResult run_process(const vector<string>& argv, uint64_t timeout_ms)
+{
+    using namespace std::chrono;
+
+    ProcessResult result;
+    if (argv.empty()) return result;
+
+    vector<char*> c_argv;
+    for (auto& arg : argv) c_argv.push_back(const_cast<char*>(arg.c_str()));
+    c_argv.push_back(nullptr);
+
+    // Own process group, default signal dispositions and an empty mask in the child
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+    posix_spawnattr_setpgroup(&attr, 0);
+    sigset_t mask, defaults;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    sigaddset(&defaults, SIGINT);
+    sigaddset(&defaults, SIGTERM);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+
+    auto start = steady_clock::now();
+    pid_t pid;
+    int err = posix_spawnp(&pid, c_argv[0], nullptr, &attr, c_argv.data(), environ);
+    posix_spawnattr_destroy(&attr);
+    if (err != 0) return result;
+    result.spawned = true;
+
+    if (timeout_ms > 0 && !wait_for_exit(pid, start + milliseconds(timeout_ms))) {
+        // The child is not reaped yet, so its process group id cannot have been reused
+        kill(-pid, SIGKILL);
+        result.timed_out = true;
+    }
+
+    int wstatus = 0;
+    struct rusage usage{};
+    while (wait4(pid, &wstatus, 0, &usage) < 0 && errno == EINTR) {}
+
+    result.wall_ms = duration<double, milli>(steady_clock::now() - start).count();
+    result.cpu_ms = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 +
+                    (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+    result.peak_rss_kb = usage.ru_maxrss;
+    if (WIFSIGNALED(wstatus)) result.signal = WTERMSIG(wstatus);
+    else if (WIFEXITED(wstatus)) result.exit_code = WEXITSTATUS(wstatus);
+    return result;
+}
+
+ProcessResult run_shell(const string& command, uint64_t timeout_ms)
+{
+    return run_process({"/bin/sh", "-c", command}, timeout_ms);
+}
@@ -1,4 +1,10 @@
 #include "tensure/random_gen.hpp"
+#include "tensure/metamorphic.hpp"
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
 
 map<char, int> map_id_to_val(const std::vector<char>& idxs)
 {
@@ -30,114 +36,223 @@ map<char, int> map_id_to_val(const std::vector<char>& idxs)
     return id_val_map;
 }
 
-TensorFormat random_format(mt19937& gen) {
-    uniform_int_distribution<int> dist(0, 1);
-    return dist(gen) ? tsSparse : tsDense;
+GeneratorConfig GeneratorConfig::large_scale()
+{
+    GeneratorConfig cfg;
+    cfg.dim_ladder = {{10, 1000}, {1000, 100000}, {100000, 4000000}};
+    cfg.density_ladder = {1e-2, 1e-4, 1e-6};
+    cfg.max_rank = 3;
+    cfg.max_nnz = uint64_t(1) << 24;
+    cfg.max_dense_volume = uint64_t(1) << 26;
+    cfg.stream = true;
+    return cfg;
 }
 
-static void __fillTensorRecursive(const tsTensor& tensor, tsTensorData& tensorData, vector<int>& current_coordinate, mt19937& gen, bernoulli_distribution& insert_dist, int depth)
+void GeneratorConfig::fromJson(const json& j)
 {
-    if (depth == tensor.shape.size())
-    {
-        // insert the data
-        uniform_real_distribution<> dist(0.0, 0.5);
-        double randomValue = dist(gen);
+    if (j.contains("dims")) {
+        dim_ladder.clear();
+        for (auto& rung : j["dims"]) {
+            if (rung.is_array()) dim_ladder.push_back({rung.at(0).get<int>(), rung.at(1).get<int>()});
+            else dim_ladder.push_back({rung.get<int>(), rung.get<int>()});
+        }
+    }
+    if (j.contains("densities")) density_ladder = j["densities"].get<vector<double>>();
+    if (j.contains("indexPool")) index_pool = j["indexPool"].get<string>();
+    if (j.contains("maxRank")) max_rank = j["maxRank"].get<int>();
+    if (j.contains("maxNnz")) max_nnz = j["maxNnz"].get<uint64_t>();
+    if (j.contains("maxDenseVolume")) max_dense_volume = j["maxDenseVolume"].get<uint64_t>();
+    validate();
+}
 
-        ostringstream oss;
-        oss << std::fixed << std::setprecision(2) << randomValue;
-        std::string strValue = oss.str();
-        // LOG_DEBUG("Inserting data: " + strValue);
+void GeneratorConfig::validate() const
+{
+    for (auto [lo, hi] : dim_ladder) {
+        if (lo < 1 || hi < lo) throw invalid_argument("Dimension rung " + to_string(lo) + ":" + to_string(hi) + " is empty or not positive");
+    }
+    if (density_ladder.empty()) throw invalid_argument("The density ladder is empty");
+    for (double density : density_ladder) {
+        if (!(density > 0.0 && density <= 1.0)) throw invalid_argument("Density " + to_string(density) + " is outside (0, 1]");
+    }
+    // Tensors are named by capitals, so indices must not be
+    for (char idx : index_pool) {
+        if (idx < 'a' || idx > 'z') throw invalid_argument("Index pool entries must be lowercase letters: " + index_pool);
+    }
+    if (set<char>(index_pool.begin(), index_pool.end()).size() != index_pool.size()) {
+        throw invalid_argument("The index pool repeats an index: " + index_pool);
+    }
+    if (max_rank < 1 || max_rank > int(index_pool.size())) {
+        throw invalid_argument("The maximum rank must be between 1 and the size of the index pool");
+    }
+    if (max_nnz == 0) throw invalid_argument("The nonzero bound must be positive");
+}
 
-        if (insert_dist(gen)) {
-            tensorData.insert(current_coordinate, stod(strValue));
+map<char, int> draw_index_extents(const vector<tsTensor>& tensors, const GeneratorConfig& cfg, mt19937& gen)
+{
+    vector<char> idxs = find_idxs(tensors);
+    map<char, int> extents;
+    if (cfg.scaled()) {
+        auto [lo, hi] = cfg.dim_ladder[uniform_int_distribution<size_t>(0, cfg.dim_ladder.size() - 1)(gen)];
+        // Log-uniform, so every order of magnitude in the rung is as likely
+        uniform_real_distribution<double> log_extent(log(double(lo)), log(double(hi) + 1.0));
+        for (char idx : idxs) extents[idx] = clamp(int(exp(log_extent(gen))), lo, hi);
+    } else {
+        extents = map_id_to_val(idxs);
+    }
+
+    // Halving an index only shrinks the tensors already checked
+    const long double max_points = ldexp(1.0L, 62);
+    for (auto& tensor : tensors) {
+        while (true) {
+            long double points = 1;
+            char largest = tensor.idxs.empty() ? 0 : tensor.idxs[0];
+            for (char idx : tensor.idxs) {
+                points *= extents[idx];
+                if (extents[idx] > extents[largest]) largest = idx;
+            }
+            if (points <= max_points) break;
+            extents[largest] = max(1, extents[largest] / 2);
         }
-        return;
-    }
-    // LOG_DEBUG("Recursive: " + to_string(tensor.shape.size()));
-    // LOG_DEBUG("Recursive depth: " + to_string(depth));
-    for (size_t i = 0; i < tensor.shape[depth]; i++) {
-        current_coordinate[depth] = i;
-        __fillTensorRecursive(tensor, tensorData, current_coordinate, gen, insert_dist, depth+1);
     }
+    return extents;
 }
 
-static bool tns_tensor_data_save(const tsTensor& tensor, const tsTensorData& tsData, const string& filename)
+bool dense_levels_fit(const tsTensor& tensor, uint64_t max_dense_volume)
 {
-    if (tsData.tfmt != "tns") {
-        cout << "Unsupported file format save function called: " << tsData.tfmt << "\n";
+    long double volume = 1;
+    for (size_t m = 0; m < tensor.shape.size() && m < tensor.storageFormat.size(); m++) {
+        volume *= tensor.shape[m];
+        if (tensor.storageFormat[m] == TensorFormat::tsDense && volume > max_dense_volume) return false;
     }
-    ofstream out(filename);
+    return true;
+}
 
-    if (!out) {
-        cerr << "Error: could not open file " << filename << endl;
-        LOG_WARN("Error: could not open file " + filename);
-        return false;
+void limit_dense_levels(tsTensor& tensor, uint64_t max_dense_volume)
+{
+    long double volume = 1;
+    for (size_t m = 0; m < tensor.shape.size() && m < tensor.storageFormat.size(); m++) {
+        volume *= tensor.shape[m];
+        if (volume > max_dense_volume) tensor.storageFormat[m] = TensorFormat::tsSparse;
     }
+}
 
-    // save the actual tensor data
-    for (size_t i = 0; i < tsData.coordinate.size(); i++)
-    {
-        for (size_t j = 0; j < tsData.coordinate[i].size(); j++)
-        {
-            out << tsData.coordinate[i][j] << " ";
+TensorFormat random_format(mt19937& gen) {
+    uniform_int_distribution<int> dist(0, 1);
+    return dist(gen) ? tsSparse : tsDense;
+}
+
+// Values are drawn from [0, 0.5] and rounded to two decimals
+static double random_value(mt19937& gen)
+{
+    uniform_real_distribution<> dist(0.0, 0.5);
+    return nearbyint(dist(gen) * 100.0) / 100.0;
+}
+
+// Number of coordinates in the dense index space of shape
+static uint64_t dense_volume(const vector<int>& shape)
+{
+    uint64_t volume = 1;
+    for (int dim : shape) {
+        if (dim <= 0) return 0;
+        if (volume > numeric_limits<uint64_t>::max() / uint64_t(dim)) {
+            throw overflow_error("Index space of the tensor has more than 2^64 points");
         }
-        out << tsData.data[i] << "\n";
+        volume *= uint64_t(dim);
     }
-    out.close();
-    return true;
+    return volume;
 }
 
-static bool ttx_tensor_data_save(const tsTensor& tensor, const tsTensorData& tsData, const string& filename)
+// Coordinate of row-major position pos (last mode fastest)
+static void decode_position(const vector<int>& shape, uint64_t pos, int32_t* coord)
 {
-    if (tsData.tfmt != "ttx") {
-        cout << "Unsupported file format save function called: " << tsData.tfmt << "\n";
+    for (size_t m = shape.size(); m-- > 0;) {
+        coord[m] = int32_t(pos % uint64_t(shape[m]));
+        pos /= uint64_t(shape[m]);
     }
+}
 
-    ofstream out(filename);
-    if (!out) {
-        cerr << "Error: could not open file " << filename << endl;
-        LOG_WARN("Error: could not open file " + filename);
-        return false;
-    }
+// Calls emit(pos) in increasing order for the positions, out of volume, that are nonzeros;
+// each one is with probability density
+template <typename Emit>
+static void sample_positions(uint64_t volume, double density, mt19937& gen, Emit emit)
+{
+    if (density <= 0.0 || volume == 0) return;
 
-    // save the header for the ttx
-    string header = "%%MatrixMarket tensor coordinate real general";
-    // if (tsData.coordinate[0].size() == 2)
-    // {
-    //     header = "%%MatrixMarket matrix coordinate real general";
-    // }
-    out << header << "\n";
+    if (density >= 1.0) {
+        for (uint64_t pos = 0; pos < volume; pos++) emit(pos);
+        return;
+    }
 
-    // save the shape of the tensor
-    for (int i = 0; i < tensor.shape.size(); i++)
-    {
-        out << tensor.shape[i] << " ";
+    // The gap to the next nonzero of independent Bernoulli(density) cells is geometric
+    geometric_distribution<uint64_t> skip(density);
+    uint64_t pos = skip(gen);
+    while (pos < volume) {
+        emit(pos);
+        uint64_t gap = skip(gen);
+        if (gap >= volume - pos - 1) break;
+        pos += gap + 1;
     }
-    out << tsData.coordinate.size() << "\n";
+}
 
-    // save the actual tensor data
-    for (size_t i = 0; i < tsData.coordinate.size(); i++)
-    {
-        for (size_t j = 0; j < tsData.coordinate[i].size(); j++)
-        {
-            out << tsData.coordinate[i][j] << " ";
-        }
-        out << tsData.data[i] << "\n";
+void sample_sparse_tensor(const vector<int>& shape, double density, mt19937& gen, tsTensorData& out)
+{
+    out.reset(shape);
+    vector<int32_t> coord(shape.size());
+    sample_positions(dense_volume(shape), density, gen, [&](uint64_t pos) {
+        decode_position(shape, pos, coord.data());
+        out.append(coord.data(), random_value(gen));
+    });
+}
+
+void sample_sparse_tensor_exact(const vector<int>& shape, uint64_t nnz, mt19937& gen, tsTensorData& out)
+{
+    out.reset(shape);
+    vector<int32_t> coord(shape.size());
+    uint64_t volume = dense_volume(shape);
+    nnz = min(nnz, volume);
+
+    // Floyd's algorithm: nnz distinct positions in O(nnz) draws
+    unordered_set<uint64_t> chosen;
+    chosen.reserve(nnz);
+    for (uint64_t j = volume - nnz; j < volume; j++) {
+        uint64_t pos = uniform_int_distribution<uint64_t>(0, j)(gen);
+        if (!chosen.insert(pos).second) chosen.insert(j);
+    }
+
+    vector<uint64_t> positions(chosen.begin(), chosen.end());
+    sort(positions.begin(), positions.end());
+    out.reserve(nnz);
+    for (uint64_t pos : positions) {
+        decode_position(shape, pos, coord.data());
+        out.append(coord.data(), random_value(gen));
     }
-    out.close();
-    return true;
+}
+
+int64_t stream_sparse_tensor(const string& path, const vector<int>& shape, double density, mt19937& gen)
+{
+    uint64_t volume = dense_volume(shape);
+    TensorFileWriter out(path, shape);
+    if (!out.is_open()) return -1;
+
+    vector<int32_t> coord(shape.size());
+    sample_positions(volume, density, gen, [&](uint64_t pos) {
+        decode_position(shape, pos, coord.data());
+        out.add(coord.data(), random_value(gen));
+    });
+    return out.close() ? int64_t(out.nnz()) : -1;
 }
 
 /**
  * This function generate random tensor data for a given tensors and return the string of filenames for each tensors.
  * 
  * */
-vector<string> generate_random_tensor_data(const vector<tsTensor>& tensors, string location, string file_name_suffix, string tfmt)
+vector<string> generate_random_tensor_data(const vector<tsTensor>& tensors, string location, string file_name_suffix, string tfmt,
+                                           const GeneratorConfig& cfg)
 {
     vector<string> datafile_names = {};
     random_device rd;
     mt19937 gen(rd());
-    bernoulli_distribution insert_dist(0.4);
+    uniform_int_distribution<size_t> pick_density(0, cfg.density_ladder.size() - 1);
 
     ensure_directory_exists(location);
 
@@ -145,28 +260,28 @@ vector<string> generate_random_tensor_data(const vector<tsTensor>& tensors, stri
     {
         auto &tensor = tensors[i];
         // cout << tensor.name << endl;
-        tsTensorData tsData;
-        tsData.tfmt = tfmt;
-        vector<int> current_coordinate(tensor.shape.size());
-        
-        // LOG_DEBUG("Inserting data to tensor: " + std::string(1, tensor.name));
-        // LOG_DEBUG("Tensor shape: " + join(tensor.shape));
-        // Fill in the tensor data
-        __fillTensorRecursive(tensor, tsData, current_coordinate, gen, insert_dist, 0);
+        double density = cfg.density_ladder[pick_density(gen)];
+        long double points = 1;
+        for (int dim : tensor.shape) points *= dim;
+        bool capped = points * density > cfg.max_nnz;
+        if (capped) density = double(cfg.max_nnz / points);
 
         // build output file path
         string filename = location + "/" + string(1,tensor.name) + (file_name_suffix == "" ? "" : "_") + file_name_suffix + "." + tfmt;
 
-        // Write to file
-        bool is_successful = false;
-        if (tfmt == "ttx") {
-            is_successful = ttx_tensor_data_save(tensor, tsData, filename);
-        } else if (tfmt == "tns")
-        {
-            is_successful = tns_tensor_data_save(tensor, tsData, filename);
+        // Write to file, in the format named by the extension
+        bool is_successful;
+        if (cfg.stream) {
+            is_successful = stream_sparse_tensor(filename, tensor.shape, density, gen) >= 0;
+        } else {
+            // A capped input gets exactly max_nnz nonzeros; a stream cannot hold the positions
+            tsTensorData data;
+            if (capped) sample_sparse_tensor_exact(tensor.shape, cfg.max_nnz, gen, data);
+            else sample_sparse_tensor(tensor.shape, density, gen, data);
+            is_successful = write_tensor_file(filename, data);
         }
-
         if (!is_successful) {
+            cerr << "Error: could not write file " << filename << endl;
             LOG_ERROR("Failed saving the tensor data file: " + filename);
             break;
         }
@@ -299,11 +414,17 @@ tuple<vector<tsTensor>, std::string> generate_random_einsum(std::string filename
 // DONE
 tuple<vector<tsTensor>, std::string> generate_random_einsum(int numInputs, int maxRank)
 {
-    // static const std::string pool = "ijklmnopqrstu";
-    static const std::string pool = "ijklmn";
+    GeneratorConfig cfg;
+    cfg.max_rank = maxRank;
+    return generate_random_einsum(numInputs, cfg);
+}
+
+tuple<vector<tsTensor>, std::string> generate_random_einsum(int numInputs, const GeneratorConfig& cfg)
+{
+    const std::string& pool = cfg.index_pool;
     std::random_device rd;
     std::mt19937 gen(rd());
-    std::uniform_int_distribution<> rankDist(1, maxRank);
+    std::uniform_int_distribution<> rankDist(1, cfg.max_rank);
     std::uniform_int_distribution<> idxDist(0, pool.size()-1);
 
     // Step 1: Generate tensors with unique indices
@@ -409,21 +530,20 @@ tuple<vector<tsTensor>, std::string> generate_random_einsum(int numInputs, int m
     }
 
     // Step 5: Build random shapes for all tensors
-    vector<char> all_idxs = find_idxs(tsTensors);
-    // std::cout << join(all_idxs) << endl;
-    map<char, int> id_val_map = map_id_to_val(all_idxs);
+    map<char, int> id_val_map = draw_index_extents(tsTensors, cfg, gen);
     for (auto &tensor : tsTensors)
     {
         for (size_t i = 0; i < tensor.idxs.size(); i++)
         {
             tensor.shape.push_back(id_val_map[tensor.idxs[i]]);
         }
+        limit_dense_levels(tensor, cfg.max_dense_volume);
     }
 
     return {tsTensors, (lhs + " = " + rhs)};
 }
 
-bool apply_sparsity_mutation(tsKernel& kernel, mt19937& gen) {
+bool apply_sparsity_mutation(tsKernel& kernel, mt19937& gen, uint64_t max_dense_volume) {
     if (kernel.tensors.empty()) return false;
 
     // 1. Pick a random tensor to mutate
@@ -432,7 +552,13 @@ bool apply_sparsity_mutation(tsKernel& kernel, mt19937& gen) {
     tsTensor& tensor = kernel.tensors[t_idx];
 
     // 2. Generate all possible formats for this tensor's shape
+    //    that keep dense levels within max_dense_volume
     vector<vector<string>> all_formats = generate_all_formats(tensor.shape.size());
+    all_formats.erase(remove_if(all_formats.begin(), all_formats.end(), [&](const vector<string>& fmt) {
+        tsTensor candidate = tensor;
+        candidate.storageFormat = parseTensorFormat(fmt);
+        return !dense_levels_fit(candidate, max_dense_volume);
+    }), all_formats.end());
     if (all_formats.empty()) return false;
 
     // 3. Pick a random format
@@ -534,6 +660,122 @@ bool apply_commutativity_mutation(tsKernel& kernel, mt19937& gen) {
     return true;
 }
 
+// Rewrite the data file of tensor with transform applied, into a new file next to the old one
+static bool transform_data_file(tsKernel& kernel, const tsTensor& tensor, const tsOutputTransform& transform, const string& suffix) {
+    auto it = kernel.dataFileNames.find(string(1, tensor.name));
+    if (it == kernel.dataFileNames.end()) return false;
+
+    CooBuffer data;
+    try {
+        read_tensor_file(it->second, data);
+        transform_tensor(transform, data);
+    } catch (const exception& e) {
+        LOG_ERROR("Data mutation failed: " + string(e.what()));
+        return false;
+    }
+
+    fs::path old_file = it->second;
+    fs::path new_file = old_file.parent_path() / (old_file.stem().string() + "_" + suffix + old_file.extension().string());
+    if (!write_tensor_file(new_file.string(), tensor.shape, data)) {
+        LOG_ERROR("Failed saving the mutated tensor data file: " + new_file.string());
+        return false;
+    }
+    it->second = new_file.string();
+    return true;
+}
+
+bool apply_scale_mutation(tsKernel& kernel, mt19937& gen, const string& suffix) {
+    if (kernel.tensors.size() < 2) return false;
+
+    // Scaling by a power of two is exact, so the expected output is exactly the scaled reference
+    static const double factors[] = {0.5, 2.0, 4.0, -1.0};
+    uniform_int_distribution<> tensor_dist(1, kernel.tensors.size() - 1);
+    uniform_int_distribution<> factor_dist(0, size(factors) - 1);
+    const tsTensor& tensor = kernel.tensors[tensor_dist(gen)];
+
+    tsOutputTransform scale;
+    scale.kind = tsOutputTransform::Scale;
+    scale.factor = factors[factor_dist(gen)];
+    if (!transform_data_file(kernel, tensor, scale, suffix)) return false;
+
+    kernel.outputTransforms.push_back(scale);
+    return true;
+}
+
+bool apply_permute_mutation(tsKernel& kernel, mt19937& gen, const string& suffix) {
+    // Any tensor, the output included (tensors[0])
+    uniform_int_distribution<> tensor_dist(0, kernel.tensors.size() - 1);
+    size_t t_idx = tensor_dist(gen);
+    tsTensor& tensor = kernel.tensors[t_idx];
+    size_t rank = tensor.idxs.size();
+    if (rank < 2) return false;
+
+    tsOutputTransform permute;
+    permute.kind = tsOutputTransform::Permute;
+    permute.perm.resize(rank);
+    iota(permute.perm.begin(), permute.perm.end(), 0);
+    while (is_sorted(permute.perm.begin(), permute.perm.end())) {
+        shuffle(permute.perm.begin(), permute.perm.end(), gen);
+    }
+
+    // The modes move together with their index labels, so the expression keeps its meaning
+    tsTensor old_tensor = tensor;
+    for (size_t m = 0; m < rank; m++) {
+        tensor.idxs[m] = old_tensor.idxs[permute.perm[m]];
+        tensor.shape[m] = old_tensor.shape[permute.perm[m]];
+        tensor.storageFormat[m] = old_tensor.storageFormat[permute.perm[m]];
+    }
+    tensor.str_repr = string(1, tensor.name) + "(" + join(tensor.idxs) + ")";
+
+    string& expr = kernel.computations[0].expressions;
+    size_t pos = expr.find(old_tensor.str_repr);
+    if (pos == string::npos) return false;
+    expr.replace(pos, old_tensor.str_repr.size(), tensor.str_repr);
+
+    // A permuted input computes the same output; a permuted output is the permuted reference
+    if (t_idx == 0) {
+        kernel.outputTransforms.push_back(permute);
+        return true;
+    }
+    return transform_data_file(kernel, tensor, permute, suffix);
+}
+
+bool apply_split_mutation(tsKernel& kernel, mt19937& gen, const string& suffix) {
+    const tsTensor& output = kernel.tensors[0];
+
+    // Slicing an input along an output index only removes the matching slices of the output
+    vector<pair<size_t, size_t>> candidates;  // (tensor, mode)
+    for (size_t t = 1; t < kernel.tensors.size(); t++) {
+        for (size_t m = 0; m < kernel.tensors[t].idxs.size(); m++) {
+            bool is_output = find(output.idxs.begin(), output.idxs.end(), kernel.tensors[t].idxs[m]) != output.idxs.end();
+            if (is_output && kernel.tensors[t].shape[m] >= 2) candidates.emplace_back(t, m);
+        }
+    }
+    if (candidates.empty()) return false;
+
+    uniform_int_distribution<> candidate_dist(0, candidates.size() - 1);
+    auto [t_idx, mode] = candidates[candidate_dist(gen)];
+    const tsTensor& tensor = kernel.tensors[t_idx];
+
+    // A random subset of the slices, neither empty nor all of them; the expected output is
+    // the reference restricted to the same slices
+    tsOutputTransform input_slice;
+    input_slice.kind = tsOutputTransform::Slice;
+    input_slice.mode = mode;
+    bernoulli_distribution keep_dist(0.5);
+    for (int c = 0; c < tensor.shape[mode]; c++) {
+        if (keep_dist(gen)) input_slice.keep.push_back(c);
+    }
+    if (input_slice.keep.empty() || input_slice.keep.size() == size_t(tensor.shape[mode])) return false;
+
+    tsOutputTransform output_slice = input_slice;
+    output_slice.mode = find(output.idxs.begin(), output.idxs.end(), tensor.idxs[mode]) - output.idxs.begin();
+    if (!transform_data_file(kernel, tensor, input_slice, suffix)) return false;
+
+    kernel.outputTransforms.push_back(output_slice);
+    return true;
+}
+
 // vector<string> sparsity_mutation(const fs::path kernel_directory, const fs::path& original_kernel_file, tsKernel &kernel, int max_mutants)
 // {
 //     vector<tsTensor>& tensors = kernel.tensors;
@@ -626,13 +868,16 @@ string get_kernel_signature(const tsKernel& kernel) {
             // Assuming TensorFormat has a string representation or enum value
             sig += to_string(static_cast<int>(fmt)) + ","; 
         }
-        sig += "|";
+        sig += join(t.idxs) + "|";
+    }
+    // Data mutations write new data files
+    for (const auto& [name, file] : kernel.dataFileNames) {
+        sig += name + "=" + file + ";";
     }
-    // Add data type info to signature if you support data mutation
     return sig;
 }
 
-string mutate_single_unique_kernel(const fs::path& directory, const string& original_kernel_filename, MutationOperator mutation_op, set<string>& generated_signatures, int mutation_id) 
+string mutate_single_unique_kernel(const fs::path& directory, const string& original_kernel_filename, MutationOperator mutation_op, set<string>& generated_signatures, int mutation_id, uint64_t max_dense_volume) 
 {
     fs::path full_filename = directory / original_kernel_filename;
     tsKernel original_kernel;
@@ -655,11 +900,20 @@ string mutate_single_unique_kernel(const fs::path& directory, const string& orig
 
         switch (mutation_op) {
             case SPARSITY:
-                mutation_success = apply_sparsity_mutation(mutant_kernel, gen);
+                mutation_success = apply_sparsity_mutation(mutant_kernel, gen, max_dense_volume);
                 break;
             case COMMUTATIVITY:
                 mutation_success = apply_commutativity_mutation(mutant_kernel, gen);
                 break;
+            case SCALE:
+                mutation_success = apply_scale_mutation(mutant_kernel, gen, "m" + to_string(mutation_id));
+                break;
+            case PERMUTE:
+                mutation_success = apply_permute_mutation(mutant_kernel, gen, "m" + to_string(mutation_id));
+                break;
+            case SPLIT:
+                mutation_success = apply_split_mutation(mutant_kernel, gen, "m" + to_string(mutation_id));
+                break;
             default:
                 break;
         }
@@ -687,16 +941,17 @@ string mutate_single_unique_kernel(const fs::path& directory, const string& orig
 
 }
 
-MutationOperator pick_random_op(std::mt19937& gen) {
-    // Create a distribution from 0 to (NUM_OPS - 1)
-    std::uniform_int_distribution<> dist(0, COUNT - 1);
+MutationOperator pick_random_op(std::mt19937& gen, bool data_mutations) {
+    // Create a distribution from 0 to (NUM_OPS - 1), or over the operators before SCALE
+    std::uniform_int_distribution<> dist(0, (data_mutations ? COUNT : SCALE) - 1);
     
     // Generate the number and cast it back to the Enum type
     int random_int = dist(gen);
     return static_cast<MutationOperator>(random_int);
 }
 
-vector<string> mutate_equivalent_kernel(const fs::path& directory, const string& original_kernel_filename, int max_mutants)
+vector<string> mutate_equivalent_kernel(const fs::path& directory, const string& original_kernel_filename, int max_mutants, uint64_t max_dense_volume,
+                                        bool data_mutations)
 {
     // 1. Initialize the pool of sources with just the original file
     vector<string> source_pool;
@@ -720,7 +975,7 @@ vector<string> mutate_equivalent_kernel(const fs::path& directory, const string&
         // Pick a random parent kernel from the pool to mutate
         uniform_int_distribution<> dist(0, source_pool.size() - 1);
         string parent_file_name = source_pool[dist(gen)];
-        string full_mutated_file_name = mutate_single_unique_kernel(directory, parent_file_name, pick_random_op(gen), generated_signatures, mutation_id);
+        string full_mutated_file_name = mutate_single_unique_kernel(directory, parent_file_name, pick_random_op(gen, data_mutations), generated_signatures, mutation_id, max_dense_volume);
         if (!full_mutated_file_name.empty()) {
             mutated_kernel_files.push_back(full_mutated_file_name);
 
@@ -0,0 +1,409 @@
+#include "tensure/tensor_compare.hpp"
+#include "tensure/tensor_io.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+#include <initializer_list>
+
+string TensorMismatch::to_string() const
+{
+    ostringstream os;
+    os << "(";
+    for (size_t m = 0; m < coord.size(); m++) {
+        os << (m ? "," : "") << coord[m];
+    }
+    os << "): ";
+    if (in_ref) os << "reference " << ref_value;
+    else os << "no reference nonzero";
+    os << ", ";
+    if (in_out) os << "output " << out_value;
+    else os << "no output nonzero";
+    return os.str();
+}
+
+// Nonzeros of one file in coordinate order without duplicates. The buffers are reused
+// by every comparison on the same thread.
+struct SortedNonzeros {
+    const CooBuffer* data = nullptr;
+    vector<uint64_t> keys;  // linearized coordinates, when the index space allows
+    vector<uint32_t> order; // otherwise, indices into data in lexicographic order
+    vector<double> values;  // in sorted order
+};
+
+struct CompareScratch {
+    CooBuffer ref_data, out_data;
+    SortedNonzeros ref, out;
+    vector<uint64_t> tmp_keys;
+    vector<double> tmp_values;
+};
+
+static thread_local CompareScratch scratch;
+
+uint64_t TensorKeySpace::key(const int32_t* c) const
+{
+    uint64_t k = 0;
+    for (size_t m = 0; m < lo.size(); m++) {
+        k = k * extent[m] + uint64_t(c[m] - lo[m]);
+    }
+    return k;
+}
+
+bool TensorKeySpace::contains(const int32_t* c) const
+{
+    for (size_t m = 0; m < lo.size(); m++) {
+        if (c[m] < lo[m] || uint64_t(c[m] - lo[m]) >= extent[m]) return false;
+    }
+    return true;
+}
+
+vector<int> TensorKeySpace::decode(uint64_t k) const
+{
+    vector<int> c(lo.size());
+    for (size_t m = lo.size(); m-- > 0;) {
+        c[m] = static_cast<int>(int64_t(k % extent[m]) + lo[m]);
+        k /= extent[m];
+    }
+    return c;
+}
+
+// Bounding box of the nonzeros of all buffers (same rank); false if it has more than 2^64 points
+static bool make_key_space(initializer_list<const CooBuffer*> buffers, TensorKeySpace& space)
+{
+    uint32_t rank = (*buffers.begin())->rank;
+    vector<int64_t> lo(rank, INT64_MAX), hi(rank, INT64_MIN);
+    for (const CooBuffer* buf : buffers) {
+        for (size_t k = 0; k < buf->nnz(); k++) {
+            if (buf->values[k] == 0.0) continue;
+            const int32_t* c = buf->coord(k);
+            for (uint32_t m = 0; m < rank; m++) {
+                lo[m] = min<int64_t>(lo[m], c[m]);
+                hi[m] = max<int64_t>(hi[m], c[m]);
+            }
+        }
+    }
+
+    space.lo.assign(rank, 0);
+    space.extent.assign(rank, 1);
+    uint64_t total = 1;
+    for (uint32_t m = 0; m < rank; m++) {
+        if (lo[m] > hi[m]) continue; // no nonzeros at all
+        space.lo[m] = lo[m];
+        space.extent[m] = uint64_t(hi[m] - lo[m]) + 1;
+        if (__builtin_mul_overflow(total, space.extent[m], &total)) return false;
+    }
+    return true;
+}
+
+// Stable LSD radix sort of keys (and values alongside), 11 bits per pass, skipping the
+// high digits no key uses
+static void radix_sort(vector<uint64_t>& keys, vector<double>& values, uint64_t max_key, vector<uint64_t>& tmp_keys, vector<double>& tmp_values)
+{
+    constexpr int DIGIT_BITS = 11;
+    constexpr size_t BUCKETS = size_t(1) << DIGIT_BITS;
+
+    size_t n = keys.size();
+    tmp_keys.resize(n);
+    tmp_values.resize(n);
+    int key_bits = max_key ? 64 - __builtin_clzll(max_key) : 0;
+
+    vector<size_t> count(BUCKETS);
+    for (int shift = 0; shift < key_bits; shift += DIGIT_BITS) {
+        fill(count.begin(), count.end(), 0);
+        for (size_t i = 0; i < n; i++) {
+            count[(keys[i] >> shift) & (BUCKETS - 1)]++;
+        }
+        size_t sum = 0;
+        for (auto& c : count) {
+            size_t bucket = c;
+            c = sum;
+            sum += bucket;
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t dst = count[(keys[i] >> shift) & (BUCKETS - 1)]++;
+            tmp_keys[dst] = keys[i];
+            tmp_values[dst] = values[i];
+        }
+        keys.swap(tmp_keys);
+        values.swap(tmp_values);
+    }
+}
+
+// False if a nonzero lies outside the key space (only possible for a space not built from data)
+static bool sort_by_key(SortedNonzeros& side, const TensorKeySpace& space, CompareScratch& s, bool check_bounds = false)
+{
+    const CooBuffer& data = *side.data;
+    side.keys.clear();
+    side.values.clear();
+    uint64_t max_key = 0;
+    for (size_t k = 0; k < data.nnz(); k++) {
+        if (data.values[k] == 0.0) continue; // skip zeros entirely
+        if (check_bounds && !space.contains(data.coord(k))) return false;
+        uint64_t key = space.key(data.coord(k));
+        side.keys.push_back(key);
+        side.values.push_back(data.values[k]);
+        max_key = max(max_key, key);
+    }
+
+    // Backends usually write in coordinate order already
+    if (!is_sorted(side.keys.begin(), side.keys.end())) {
+        radix_sort(side.keys, side.values, max_key, s.tmp_keys, s.tmp_values);
+    }
+
+    // The sort is stable, so the first of equal keys is the first in the file
+    size_t n = 0;
+    for (size_t i = 0; i < side.keys.size(); i++) {
+        if (n > 0 && side.keys[i] == side.keys[n - 1]) continue;
+        side.keys[n] = side.keys[i];
+        side.values[n] = side.values[i];
+        n++;
+    }
+    side.keys.resize(n);
+    side.values.resize(n);
+    return true;
+}
+
+static int compare_rows(const int32_t* a, const int32_t* b, uint32_t rank)
+{
+    for (uint32_t m = 0; m < rank; m++) {
+        if (a[m] != b[m]) return a[m] < b[m] ? -1 : 1;
+    }
+    return 0;
+}
+
+// Fallback for index spaces with more than 2^64 points
+static void sort_lexicographic(SortedNonzeros& side)
+{
+    const CooBuffer& data = *side.data;
+    side.order.clear();
+    for (size_t k = 0; k < data.nnz(); k++) {
+        if (data.values[k] != 0.0) side.order.push_back(static_cast<uint32_t>(k));
+    }
+    stable_sort(side.order.begin(), side.order.end(), [&](uint32_t a, uint32_t b) {
+        return compare_rows(data.coord(a), data.coord(b), data.rank) < 0;
+    });
+    auto last = unique(side.order.begin(), side.order.end(), [&](uint32_t a, uint32_t b) {
+        return compare_rows(data.coord(a), data.coord(b), data.rank) == 0;
+    });
+    side.order.erase(last, side.order.end());
+
+    side.values.clear();
+    for (uint32_t k : side.order) side.values.push_back(data.values[k]);
+}
+
+// Index of the first pair further apart than tol, or n. Checked in blocks with a
+// branch-free inner loop the compiler vectorizes.
+static size_t first_out_of_tolerance(const double* a, const double* b, size_t n, double tol)
+{
+    constexpr size_t BLOCK = 512;
+    for (size_t begin = 0; begin < n; begin += BLOCK) {
+        size_t end = min(n, begin + BLOCK);
+        int bad = 0;
+        for (size_t i = begin; i < end; i++) {
+            bad |= fabs(a[i] - b[i]) > tol;
+        }
+        if (!bad) continue;
+        for (size_t i = begin; i < end; i++) {
+            if (fabs(a[i] - b[i]) > tol) return i;
+        }
+    }
+    return n;
+}
+
+// Single pass over both sorted sides. cmp(i, j) orders ref entry i against out entry j;
+// coord(is_ref, i) returns the coordinate of entry i of that side.
+template <typename Cmp, typename Coord>
+static bool merge_compare(const vector<double>& ref_values, const vector<double>& out_values, double tol, Cmp cmp, Coord coord, TensorMismatch* mismatch)
+{
+    size_t nr = ref_values.size(), no = out_values.size();
+    size_t i = 0, j = 0;
+    while (i < nr && j < no) {
+        int c = cmp(i, j);
+        if (c != 0 || fabs(ref_values[i] - out_values[j]) > tol) {
+            if (mismatch) {
+                mismatch->coord = c <= 0 ? coord(true, i) : coord(false, j);
+                mismatch->in_ref = c <= 0;
+                mismatch->in_out = c >= 0;
+                mismatch->ref_value = c <= 0 ? ref_values[i] : 0.0;
+                mismatch->out_value = c >= 0 ? out_values[j] : 0.0;
+            }
+            return false;
+        }
+        i++;
+        j++;
+    }
+    if (i == nr && j == no) return true;
+
+    if (mismatch) {
+        mismatch->in_ref = i < nr;
+        mismatch->in_out = j < no;
+        mismatch->coord = i < nr ? coord(true, i) : coord(false, j);
+        mismatch->ref_value = i < nr ? ref_values[i] : 0.0;
+        mismatch->out_value = j < no ? out_values[j] : 0.0;
+    }
+    return false;
+}
+
+// Nonzeros of a rank-mismatched pair: equal only if neither has one
+static bool compare_ranks_differ(const CooBuffer& ref, const CooBuffer& out, TensorMismatch* mismatch)
+{
+    auto first_nonzero = [](const CooBuffer& b) {
+        return size_t(find_if(b.values.begin(), b.values.end(), [](double v) { return v != 0.0; }) - b.values.begin());
+    };
+    size_t r = first_nonzero(ref), o = first_nonzero(out);
+    if (r == ref.nnz() && o == out.nnz()) return true;
+    if (mismatch) {
+        const CooBuffer& b = r < ref.nnz() ? ref : out;
+        size_t k = r < ref.nnz() ? r : o;
+        *mismatch = TensorMismatch();
+        mismatch->coord.assign(b.coord(k), b.coord(k) + b.rank);
+        mismatch->in_ref = &b == &ref;
+        mismatch->in_out = !mismatch->in_ref;
+        (mismatch->in_ref ? mismatch->ref_value : mismatch->out_value) = b.values[k];
+    }
+    return false;
+}
+
+// Compare sides sorted in the same key space
+static bool compare_keyed(const vector<uint64_t>& ref_keys, const vector<double>& ref_values, const SortedNonzeros& out,
+                          const TensorKeySpace& space, double tol, TensorMismatch* mismatch)
+{
+    // Common case: identical coordinates, so only the values need checking
+    size_t n = ref_keys.size();
+    if (n == out.keys.size() && equal(ref_keys.begin(), ref_keys.end(), out.keys.begin())) {
+        size_t i = first_out_of_tolerance(ref_values.data(), out.values.data(), n, tol);
+        if (i == n) return true;
+        if (mismatch) {
+            mismatch->coord = space.decode(ref_keys[i]);
+            mismatch->in_ref = mismatch->in_out = true;
+            mismatch->ref_value = ref_values[i];
+            mismatch->out_value = out.values[i];
+        }
+        return false;
+    }
+
+    auto cmp = [&](size_t i, size_t j) {
+        uint64_t a = ref_keys[i], b = out.keys[j];
+        return a < b ? -1 : (a > b ? 1 : 0);
+    };
+    auto coord = [&](bool is_ref, size_t i) { return space.decode(is_ref ? ref_keys[i] : out.keys[i]); };
+    return merge_compare(ref_values, out.values, tol, cmp, coord, mismatch);
+}
+
+static bool compare_loaded(const CooBuffer& ref, const CooBuffer& out, double tol, TensorMismatch* mismatch, CompareScratch& s)
+{
+    if (ref.rank != out.rank) return compare_ranks_differ(ref, out, mismatch);
+
+    s.ref.data = &ref;
+    s.out.data = &out;
+    TensorKeySpace space;
+    if (!make_key_space({&ref, &out}, space)) {
+        sort_lexicographic(s.ref);
+        sort_lexicographic(s.out);
+        uint32_t rank = ref.rank;
+        auto cmp = [&](size_t i, size_t j) {
+            return compare_rows(ref.coord(s.ref.order[i]), out.coord(s.out.order[j]), rank);
+        };
+        auto coord = [&](bool is_ref, size_t i) {
+            const int32_t* c = is_ref ? ref.coord(s.ref.order[i]) : out.coord(s.out.order[i]);
+            return vector<int>(c, c + rank);
+        };
+        return merge_compare(s.ref.values, s.out.values, tol, cmp, coord, mismatch);
+    }
+
+    sort_by_key(s.ref, space, s);
+    sort_by_key(s.out, space, s);
+    return compare_keyed(s.ref.keys, s.ref.values, s.out, space, tol, mismatch);
+}
+
+bool compare_tensor_files(const string& ref_file, const string& out_file, double tol, TensorMismatch* mismatch)
+{
+    CompareScratch& s = scratch;
+    read_tensor_file(ref_file, s.ref_data);
+    read_tensor_file(out_file, s.out_data);
+    return compare_loaded(s.ref_data, s.out_data, tol, mismatch, s);
+}
+
+ReferenceTensor::ReferenceTensor(const string& ref_file)
+{
+    read_tensor_file(ref_file, data);
+
+    keyed = make_key_space({&data}, space);
+    if (keyed) {
+        SortedNonzeros side;
+        side.data = &data;
+        sort_by_key(side, space, scratch);
+        keys = move(side.keys);
+        values = move(side.values);
+    }
+}
+
+bool ReferenceTensor::compare(const string& out_file, double tol, TensorMismatch* mismatch) const
+{
+    CompareScratch& s = scratch;
+    read_tensor_file(out_file, s.out_data);
+    if (!keyed || data.rank != s.out_data.rank) return compare_loaded(data, s.out_data, tol, mismatch, s);
+
+    // A nonzero outside the reference's bounding box is a mismatch either way; the full
+    // comparison finds which coordinate comes first
+    s.out.data = &s.out_data;
+    if (!sort_by_key(s.out, space, s, true)) return compare_loaded(data, s.out_data, tol, mismatch, s);
+
+    return compare_keyed(keys, values, s.out, space, tol, mismatch);
+}
+
+ReferenceStream::ReferenceStream(const ReferenceTensor& ref, double tol) : ref(ref), tol(tol), seen(ref.keys.size()) {}
+
+bool ReferenceStream::add(const CooBuffer& chunk, TensorMismatch* mismatch)
+{
+    const vector<uint64_t>& keys = ref.keys;
+    for (size_t k = 0; k < chunk.nnz(); k++) {
+        double value = chunk.values[k];
+        if (value == 0.0) continue;
+        const int32_t* c = chunk.coord(k);
+
+        size_t i = keys.size();
+        if (chunk.rank == ref.data.rank && ref.space.contains(c)) {
+            uint64_t key = ref.space.key(c);
+            // Outputs mostly arrive in coordinate order, right after the previous match
+            if (next < keys.size() && keys[next] == key) {
+                i = next;
+            } else {
+                auto it = lower_bound(keys.begin(), keys.end(), key);
+                if (it != keys.end() && *it == key) i = it - keys.begin();
+            }
+        }
+
+        if (i < keys.size() && seen[i]) continue;
+        if (i == keys.size() || fabs(ref.values[i] - value) > tol) {
+            if (mismatch) {
+                *mismatch = TensorMismatch();
+                mismatch->coord.assign(c, c + chunk.rank);
+                mismatch->in_ref = i < keys.size();
+                mismatch->in_out = true;
+                mismatch->ref_value = i < keys.size() ? ref.values[i] : 0.0;
+                mismatch->out_value = value;
+            }
+            return false;
+        }
+        seen[i] = true;
+        matched++;
+        next = i + 1;
+    }
+    return true;
+}
+
+bool ReferenceStream::finish(TensorMismatch* mismatch)
+{
+    if (matched == seen.size()) return true;
+    if (mismatch) {
+        size_t i = find(seen.begin(), seen.end(), 0) - seen.begin();
+        *mismatch = TensorMismatch();
+        mismatch->coord = ref.space.decode(ref.keys[i]);
+        mismatch->in_ref = true;
+        mismatch->ref_value = ref.values[i];
+    }
+    return false;
+}
@@ -0,0 +1,53 @@
+#include "tensure/tensor_data.hpp"
+
+#include <numeric>
+#include <stdexcept>
+
+// Narrowest width holding every index below extent
+static uint8_t width_for(int extent)
+{
+    if (extent <= 0x100) return 1;
+    if (extent <= 0x10000) return 2;
+    return 4;
+}
+
+void TensorData::reset(const vector<int>& shape)
+{
+    for (int dim : shape) {
+        if (dim < 0) throw invalid_argument("Negative tensor dimension");
+    }
+    shape_ = shape;
+    widths_.clear();
+    for (int dim : shape) widths_.push_back(width_for(dim));
+    modes_.assign(shape.size(), {});
+    values_.clear();
+}
+
+size_t TensorData::bytes_per_nonzero() const
+{
+    return accumulate(widths_.begin(), widths_.end(), sizeof(double));
+}
+
+void TensorData::reserve(size_t nnz)
+{
+    for (uint32_t m = 0; m < rank(); m++) modes_[m].reserve(nnz * widths_[m]);
+    values_.reserve(nnz);
+}
+
+void TensorData::append(const int32_t* coord, double value)
+{
+    for (uint32_t m = 0; m < rank(); m++) {
+        if (coord[m] < 0 || coord[m] >= shape_[m]) throw out_of_range("Coordinate outside the tensor's shape");
+    }
+    for (uint32_t m = 0; m < rank(); m++) {
+        auto& mode = modes_[m];
+        size_t at = mode.size();
+        mode.resize(at + widths_[m]);
+        switch (widths_[m]) {
+        case 1: mode[at] = uint8_t(coord[m]); break;
+        case 2: { uint16_t v = uint16_t(coord[m]); memcpy(&mode[at], &v, 2); break; }
+        default: memcpy(&mode[at], &coord[m], 4); break;
+        }
+    }
+    values_.push_back(value);
+}
@@ -0,0 +1,565 @@
+#include "tensure/tensor_io.hpp"
+#include "tensure/tensor_data.hpp"
+
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <charconv>
+#include <algorithm>
+#include <stdexcept>
+#include <exception>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+const char BIN_TENSOR_MAGIC[8] = {'T', 'S', 'C', 'O', 'O', '\0', '\0', '\0'};
+
+static constexpr size_t BIN_HEADER_SIZE = 8 + 4 + 4 + 8;
+
+static size_t align8(size_t n) { return (n + 7) & ~size_t(7); }
+
+bool is_bin_tensor_file(const string& path)
+{
+    return path.size() >= 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+}
+
+// Writes the sections in order; get_mode(m) returns a pointer to mode m's nnz coordinates
+template <typename ModeFn>
+static bool write_bin_sections(const string& path, const vector<int>& shape, uint64_t nnz, ModeFn get_mode, const double* values)
+{
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) return false;
+
+    uint32_t version = BIN_TENSOR_VERSION;
+    uint32_t rank = shape.size();
+    vector<uint64_t> dims(shape.begin(), shape.end());
+    bool ok = fwrite(BIN_TENSOR_MAGIC, 1, 8, out) == 8 &&
+              fwrite(&version, sizeof(version), 1, out) == 1 &&
+              fwrite(&rank, sizeof(rank), 1, out) == 1 &&
+              fwrite(&nnz, sizeof(nnz), 1, out) == 1 &&
+              fwrite(dims.data(), sizeof(uint64_t), rank, out) == rank;
+
+    for (uint32_t m = 0; m < rank && ok; m++) {
+        ok = fwrite(get_mode(m), sizeof(int32_t), nnz, out) == nnz;
+    }
+    size_t coord_bytes = size_t(rank) * nnz * sizeof(int32_t);
+    static const char zeros[8] = {};
+    size_t padding = align8(coord_bytes) - coord_bytes;
+    ok = ok && fwrite(zeros, 1, padding, out) == padding;
+    ok = ok && fwrite(values, sizeof(double), nnz, out) == nnz;
+
+    ok = (fclose(out) == 0) && ok;
+    return ok;
+}
+
+bool write_bin_tensor_by_mode(const string& path, const vector<int>& shape, const vector<vector<int32_t>>& mode_coords, const vector<double>& values)
+{
+    if (mode_coords.size() != shape.size()) return false;
+    for (auto& mode : mode_coords) {
+        if (mode.size() != values.size()) return false;
+    }
+    return write_bin_sections(path, shape, values.size(), [&](uint32_t m) { return mode_coords[m].data(); }, values.data());
+}
+
+MappedFile::MappedFile(const string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw runtime_error("Cannot open " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw runtime_error("Cannot open " + path);
+    }
+    length = st.st_size;
+    if (length == 0) {
+        close(fd);
+        return;
+    }
+    base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        base = nullptr;
+        throw runtime_error("Cannot map " + path);
+    }
+    // Every reader goes front to back
+    madvise(base, length, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile()
+{
+    if (base) munmap(base, length);
+}
+
+MappedBinTensor::MappedBinTensor(const string& path) : file(path)
+{
+    size_t length = file.size();
+    const char* p = file.data();
+    if (length < BIN_HEADER_SIZE) throw runtime_error("Not a binary tensor file: " + path);
+
+    uint32_t version;
+    memcpy(&version, p + 8, sizeof(version));
+    memcpy(&rank_, p + 12, sizeof(rank_));
+    memcpy(&nnz_, p + 16, sizeof(nnz_));
+
+    // Bounded first, so the size computation below cannot overflow
+    bool valid = memcmp(p, BIN_TENSOR_MAGIC, 8) == 0 && version == BIN_TENSOR_VERSION &&
+                 rank_ <= 64 && nnz_ <= length;
+    size_t shape_end = BIN_HEADER_SIZE + size_t(rank_) * sizeof(uint64_t);
+    size_t values_begin = valid ? align8(shape_end + size_t(rank_) * nnz_ * sizeof(int32_t)) : 0;
+    if (!valid || values_begin + nnz_ * sizeof(double) != length) {
+        throw runtime_error("Not a binary tensor file: " + path);
+    }
+
+    shape_ = reinterpret_cast<const uint64_t*>(p + BIN_HEADER_SIZE);
+    coords_ = reinterpret_cast<const int32_t*>(p + shape_end);
+    values_ = reinterpret_cast<const double*>(p + values_begin);
+}
+
+// ---------------------------------------------------------------------------
+// Text codec
+// ---------------------------------------------------------------------------
+
+// Same bound as the binary format; a line holds at most MAX_TEXT_RANK + 1 numbers
+static constexpr int MAX_TEXT_RANK = 64;
+
+static bool has_size_line(const string& path)
+{
+    string ext = fs::path(path).extension().string();
+    return ext == ".ttx" || ext == ".mtx";
+}
+
+static bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static bool at_token_end(const char* p, const char* end) { return p == end || is_blank(*p) || *p == '\n'; }
+
+static const char* skip_line(const char* p, const char* end)
+{
+    const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    return eol ? eol + 1 : end;
+}
+
+[[noreturn]] static void malformed(const string& path, const char* line, const char* end)
+{
+    const char* eol = static_cast<const char*>(memchr(line, '\n', end - line));
+    throw runtime_error("Malformed line in " + path + ": " + string(line, eol ? eol : end));
+}
+
+// Next line that is not blank or a comment, or end
+static const char* next_data_line(const char* p, const char* end)
+{
+    while (p < end) {
+        while (p < end && is_blank(*p)) p++;
+        if (p < end && *p != '\n' && *p != '#' && *p != '%') return p;
+        p = skip_line(p, end);
+    }
+    return end;
+}
+
+// Parses the integer and trailing (possibly floating-point) numbers of the line at p into
+// ints/value. Returns the number of coordinates and sets p past the line.
+static int parse_line(const char*& p, const char* end, int64_t* ints, double& value, const string& path)
+{
+    const char* line = p;
+    int n = 0;
+    bool have_value = false;
+    while (true) {
+        if (n > MAX_TEXT_RANK) malformed(path, line, end);
+
+        int64_t iv;
+        auto r = from_chars(p, end, iv);
+        if (r.ec == errc() && at_token_end(r.ptr, end)) {
+            ints[n++] = iv;
+            p = r.ptr;
+        } else {
+            // Only the value may be fractional, so it ends the line
+            auto rd = from_chars(p, end, value);
+            if (rd.ec != errc() || !at_token_end(rd.ptr, end)) malformed(path, line, end);
+            p = rd.ptr;
+            have_value = true;
+        }
+
+        while (p < end && is_blank(*p)) p++;
+        if (p == end || *p == '\n') break;
+        if (have_value) malformed(path, line, end);
+    }
+    if (p < end) p++;
+
+    if (!have_value) {
+        value = static_cast<double>(ints[--n]);
+    }
+    return n;
+}
+
+// Parse the data lines in [p, end). rank is -1 until a line fixes it.
+static void parse_lines(const char* p, const char* end, CooBuffer& out, int& rank, const string& path)
+{
+    int64_t ints[MAX_TEXT_RANK + 1];
+    double value;
+    while ((p = next_data_line(p, end)) < end) {
+        const char* line = p;
+        int n = parse_line(p, end, ints, value, path);
+        if (rank < 0) rank = n;
+        if (n != rank) malformed(path, line, end);
+
+        for (int m = 0; m < n; m++) {
+            if (ints[m] < INT32_MIN || ints[m] > INT32_MAX) malformed(path, line, end);
+            out.coords.push_back(static_cast<int32_t>(ints[m]));
+        }
+        out.values.push_back(value);
+    }
+}
+
+static void read_text_tensor(const string& path, CooBuffer& out, unsigned threads)
+{
+    MappedFile file(path);
+    const char* p = file.data();
+    const char* end = p + file.size();
+
+    if (has_size_line(path) && (p = next_data_line(p, end)) < end) {
+        const char* line = p;
+        int64_t ints[MAX_TEXT_RANK + 1];
+        double nnz;
+        int n = parse_line(p, end, ints, nnz, path);
+        if (!(nnz >= 0)) malformed(path, line, end);
+        out.shape.assign(ints, ints + n);
+        // A line takes at least 2 bytes per number, whatever the size line claims
+        size_t expected = min(static_cast<size_t>(min(nnz, 1e18)), size_t(end - p) / (2 * (n + 1)) + 1);
+        out.coords.reserve(expected * n);
+        out.values.reserve(expected);
+    }
+
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    size_t bytes = end - p;
+    size_t chunks = bytes < PARALLEL_PARSE_MIN_BYTES ? 1 : min<size_t>(threads, bytes / (PARALLEL_PARSE_MIN_BYTES / 4));
+
+    int rank = -1;
+    if (chunks <= 1) {
+        parse_lines(p, end, out, rank, path);
+    } else {
+        // Chunk boundaries are moved forward to the next line start
+        vector<const char*> bounds = {p};
+        for (size_t c = 1; c < chunks; c++) {
+            const char* b = max(bounds.back(), skip_line(p + bytes * c / chunks, end));
+            bounds.push_back(b);
+        }
+        bounds.push_back(end);
+
+        // The first chunk goes straight into out, the others are appended in order
+        vector<CooBuffer> parts(chunks - 1);
+        vector<int> ranks(chunks, -1);
+        vector<exception_ptr> errors(chunks);
+        vector<thread> workers;
+        for (size_t c = 0; c < chunks; c++) {
+            auto work = [&, c] {
+                try {
+                    parse_lines(bounds[c], bounds[c + 1], c == 0 ? out : parts[c - 1], ranks[c], path);
+                } catch (...) {
+                    errors[c] = current_exception();
+                }
+            };
+            if (c + 1 < chunks) workers.emplace_back(work);
+            else work();
+        }
+        for (auto& w : workers) w.join();
+        for (auto& e : errors) {
+            if (e) rethrow_exception(e);
+        }
+
+        size_t total = out.values.size();
+        for (auto& part : parts) total += part.values.size();
+        out.values.reserve(total);
+        out.coords.reserve(out.coords.size() + (total - out.values.size()) * max(0, ranks[0]));
+        for (size_t c = 0; c < chunks; c++) {
+            if (ranks[c] < 0) continue;
+            if (rank >= 0 && ranks[c] != rank) {
+                throw runtime_error("Malformed file " + path + ": lines with " + to_string(rank) + " and " +
+                                    to_string(ranks[c]) + " coordinates");
+            }
+            rank = ranks[c];
+            if (c == 0) continue;
+            out.coords.insert(out.coords.end(), parts[c - 1].coords.begin(), parts[c - 1].coords.end());
+            out.values.insert(out.values.end(), parts[c - 1].values.begin(), parts[c - 1].values.end());
+        }
+    }
+
+    // An empty file says nothing about the rank; the size line does
+    out.rank = rank >= 0 ? rank : out.shape.size();
+}
+
+void read_tensor_file(const string& path, CooBuffer& out, unsigned threads)
+{
+    out.clear();
+    if (!is_bin_tensor_file(path)) {
+        read_text_tensor(path, out, threads);
+        return;
+    }
+
+    MappedBinTensor bin(path);
+    out.rank = bin.rank();
+    for (uint32_t m = 0; m < bin.rank(); m++) {
+        out.shape.push_back(static_cast<int>(bin.dim(m)));
+    }
+    out.values.assign(bin.values(), bin.values() + bin.nnz());
+    out.coords.resize(size_t(bin.rank()) * bin.nnz());
+    for (uint32_t m = 0; m < bin.rank(); m++) {
+        const int32_t* mode = bin.coords(m);
+        for (uint64_t k = 0; k < bin.nnz(); k++) {
+            out.coords[k * bin.rank() + m] = mode[k];
+        }
+    }
+}
+
+void TextTensorStream::parse(const char* p, const char* end, CooBuffer& out)
+{
+    if (rank >= 0) out.rank = rank;
+    parse_lines(p, end, out, rank, name);
+    if (rank >= 0) out.rank = rank;
+}
+
+void TextTensorStream::feed(const char* data, size_t size, CooBuffer& out)
+{
+    const char* end = data + size;
+    if (!partial.empty()) {
+        const char* eol = static_cast<const char*>(memchr(data, '\n', size));
+        if (!eol) {
+            partial.append(data, size);
+            return;
+        }
+        partial.append(data, eol + 1);
+        parse(partial.data(), partial.data() + partial.size(), out);
+        partial.clear();
+        data = eol + 1;
+    }
+
+    const char* last = end;
+    while (last > data && last[-1] != '\n') last--;
+    parse(data, last, out);
+    partial.assign(last, end);
+}
+
+void TextTensorStream::finish(CooBuffer& out)
+{
+    parse(partial.data(), partial.data() + partial.size(), out);
+    partial.clear();
+}
+
+// Buffered writer formatting numbers with to_chars. put() copies raw bytes, so it also
+// buffers the binary spools of TensorFileWriter.
+class TextWriter {
+public:
+    explicit TextWriter(const string& path) : out(fopen(path.c_str(), "wb")) {}
+    ~TextWriter()
+    {
+        if (out) fclose(out);
+    }
+
+    bool is_open() const { return out != nullptr; }
+
+    void put(const char* s, size_t n)
+    {
+        if (len + n > sizeof(buf)) flush();
+        memcpy(buf + len, s, n);
+        len += n;
+    }
+    void put(char c) { put(&c, 1); }
+    template <typename T>
+    void put_number(T v)
+    {
+        // Shortest representation that reads back to the same double
+        if (len + 32 > sizeof(buf)) flush();
+        len = to_chars(buf + len, buf + sizeof(buf), v).ptr - buf;
+    }
+
+    bool close()
+    {
+        flush();
+        bool ok_close = fclose(out) == 0;
+        out = nullptr;
+        return ok && ok_close;
+    }
+
+private:
+    FILE* out;
+    char buf[1 << 16];
+    size_t len = 0;
+    bool ok = true;
+
+    void flush()
+    {
+        ok = ok && fwrite(buf, 1, len, out) == len;
+        len = 0;
+    }
+};
+
+// "%%MatrixMarket" header and size line of a ".ttx" or ".mtx" file
+static string size_line_header(const string& path, const vector<int>& shape, uint64_t nnz)
+{
+    string ext = fs::path(path).extension().string();
+    string header = ext == ".mtx" ? "%%MatrixMarket matrix coordinate real general\n"
+                                  : "%%MatrixMarket tensor coordinate real general\n";
+    for (int dim : shape) header += to_string(dim) + " ";
+    return header + to_string(nnz) + "\n";
+}
+
+// get_coord(k) returns a pointer to the rank coordinates of nonzero k
+template <typename CoordFn>
+static bool write_text_tensor(const string& path, const vector<int>& shape, size_t rank, size_t nnz, CoordFn get_coord, const double* values)
+{
+    TextWriter out(path);
+    if (!out.is_open()) return false;
+
+    if (has_size_line(path)) {
+        string header = size_line_header(path, shape, nnz);
+        out.put(header.data(), header.size());
+    }
+
+    for (size_t k = 0; k < nnz; k++) {
+        auto coord = get_coord(k);
+        for (size_t m = 0; m < rank; m++) {
+            out.put_number(coord[m]);
+            out.put(' ');
+        }
+        out.put_number(values[k]);
+        out.put('\n');
+    }
+    return out.close();
+}
+
+bool write_tensor_file(const string& path, const vector<int>& shape, const CooBuffer& data)
+{
+    if (is_bin_tensor_file(path)) {
+        vector<vector<int32_t>> mode_coords(data.rank, vector<int32_t>(data.nnz()));
+        for (size_t k = 0; k < data.nnz(); k++) {
+            for (uint32_t m = 0; m < data.rank; m++) {
+                mode_coords[m][k] = data.coord(k)[m];
+            }
+        }
+        return write_bin_tensor_by_mode(path, shape, mode_coords, data.values);
+    }
+    return write_text_tensor(path, shape, data.rank, data.nnz(), [&](size_t k) { return data.coord(k); }, data.values.data());
+}
+
+bool write_tensor_file(const string& path, const TensorData& data)
+{
+    uint32_t rank = data.rank();
+    size_t nnz = data.nnz();
+    if (is_bin_tensor_file(path)) {
+        // One mode at a time, widened to the file's 32-bit indices
+        vector<int32_t> mode(nnz);
+        auto get_mode = [&](uint32_t m) {
+            for (size_t k = 0; k < nnz; k++) mode[k] = data.index(m, k);
+            return mode.data();
+        };
+        return write_bin_sections(path, data.shape(), nnz, get_mode, data.values().data());
+    }
+
+    vector<int32_t> coord(rank);
+    auto get_coord = [&](size_t k) {
+        data.coord(k, coord.data());
+        return coord.data();
+    };
+    return write_text_tensor(path, data.shape(), rank, nnz, get_coord, data.values().data());
+}
+
+struct TensorFileWriter::Spools {
+    vector<string> paths;                   // removed by the destructor
+    vector<unique_ptr<TextWriter>> files;   // text body, or one per mode then the values
+};
+
+TensorFileWriter::TensorFileWriter(const string& path, const vector<int>& shape)
+    : path(path), shape(shape), spools(make_unique<Spools>())
+{
+    // A ".tns" body is the file; the others are spooled
+    size_t parts = is_bin_tensor_file(path) ? shape.size() + 1 : 1;
+    bool in_place = !is_bin_tensor_file(path) && !has_size_line(path);
+    open = true;
+    for (size_t n = 0; n < parts; n++) {
+        string file = in_place ? path : path + ".part" + to_string(n);
+        if (!in_place) spools->paths.push_back(file);
+        spools->files.push_back(make_unique<TextWriter>(file));
+        open = open && spools->files.back()->is_open();
+    }
+}
+
+TensorFileWriter::~TensorFileWriter()
+{
+    spools->files.clear();
+    error_code ec;
+    for (auto& file : spools->paths) fs::remove(file, ec);
+    if (!closed) fs::remove(path, ec);
+}
+
+void TensorFileWriter::add(const int32_t* coord, double value)
+{
+    for (size_t m = 0; m < shape.size(); m++) {
+        if (coord[m] < 0 || coord[m] >= shape[m]) throw out_of_range("Coordinate outside the tensor's shape");
+    }
+    auto& files = spools->files;
+    if (is_bin_tensor_file(path)) {
+        for (size_t m = 0; m < shape.size(); m++) files[m]->put(reinterpret_cast<const char*>(&coord[m]), sizeof(int32_t));
+        files.back()->put(reinterpret_cast<const char*>(&value), sizeof(double));
+    } else {
+        TextWriter& out = *files[0];
+        for (size_t m = 0; m < shape.size(); m++) {
+            out.put_number(coord[m]);
+            out.put(' ');
+        }
+        out.put_number(value);
+        out.put('\n');
+    }
+    count++;
+}
+
+// Append the whole file src to out
+static bool append_file(FILE* out, const string& src)
+{
+    FILE* in = fopen(src.c_str(), "rb");
+    if (!in) return false;
+    static thread_local char buf[1 << 16];
+    bool ok = true;
+    size_t n;
+    while (ok && (n = fread(buf, 1, sizeof(buf), in)) > 0) ok = fwrite(buf, 1, n, out) == n;
+    ok = ok && !ferror(in);
+    fclose(in);
+    return ok;
+}
+
+bool TensorFileWriter::close()
+{
+    if (!open) return false;
+    open = false;
+    bool ok = true;
+    for (auto& file : spools->files) ok = file->close() && ok;
+    spools->files.clear();
+    if (spools->paths.empty() || !ok) return closed = ok;
+
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) return false;
+    if (is_bin_tensor_file(path)) {
+        uint32_t version = BIN_TENSOR_VERSION;
+        uint32_t rank = shape.size();
+        vector<uint64_t> dims(shape.begin(), shape.end());
+        ok = fwrite(BIN_TENSOR_MAGIC, 1, 8, out) == 8 &&
+             fwrite(&version, sizeof(version), 1, out) == 1 &&
+             fwrite(&rank, sizeof(rank), 1, out) == 1 &&
+             fwrite(&count, sizeof(count), 1, out) == 1 &&
+             fwrite(dims.data(), sizeof(uint64_t), rank, out) == rank;
+        for (uint32_t m = 0; m < rank && ok; m++) ok = append_file(out, spools->paths[m]);
+        size_t coord_bytes = size_t(rank) * count * sizeof(int32_t);
+        static const char zeros[8] = {};
+        size_t padding = align8(coord_bytes) - coord_bytes;
+        ok = ok && fwrite(zeros, 1, padding, out) == padding;
+        ok = ok && append_file(out, spools->paths.back());
+    } else {
+        string header = size_line_header(path, shape, count);
+        ok = fwrite(header.data(), 1, header.size(), out) == header.size() && append_file(out, spools->paths[0]);
+    }
+    ok = (fclose(out) == 0) && ok;
+    return closed = ok;
+}